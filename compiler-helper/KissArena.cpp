@@ -0,0 +1,110 @@
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <algorithm>
+#include <memory_resource>
+#include <KissArena.hpp>
+
+using namespace kisslang;
+
+FrameArena::Block *FrameArena::_freeBlocks = nullptr;
+std::size_t FrameArena::_globalBytesInUse = 0;
+std::size_t FrameArena::_globalPeakBytes = 0;
+std::size_t FrameArena::_globalTotalBytes = 0;
+
+FrameArena::FrameArena() :
+        _newest(nullptr), _oldest(nullptr), _cursor(nullptr), _end(nullptr),
+        _bytesInUse(0), _peakBytes(0), _totalBytes(0) {
+}
+
+FrameArena::~FrameArena() {
+    release();
+}
+
+// Hands every block back to the free list at once, no matter how many
+void FrameArena::release() {
+    if(_oldest != nullptr) {
+        _oldest->next = _freeBlocks;
+        _freeBlocks = _newest;
+    }
+    _globalBytesInUse -= _bytesInUse;
+    _newest = _oldest = nullptr;
+    _cursor = _end = nullptr;
+    _bytesInUse = 0;
+}
+
+// Reuses the first free block big enough before asking for a new one
+void FrameArena::_grow(const std::size_t minBytes) {
+    Block *block = nullptr;
+    for(auto link = &_freeBlocks; *link != nullptr; link = &(*link)->next) {
+        if((*link)->size >= minBytes) {
+            block = *link;
+            *link = block->next;
+            break;
+        }
+    }
+    if(block == nullptr) {
+        const auto size = std::max(blockSize, minBytes);
+        block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+        block->size = size;
+    }
+
+    block->next = _newest;
+    _newest = block;
+    if(_oldest == nullptr) {
+        _oldest = block;
+    }
+    _cursor = reinterpret_cast<char *>(block + 1);
+    _end = _cursor + block->size;
+}
+
+void *FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void *ptr = _cursor;
+    std::size_t space = _end - _cursor;
+    if(_cursor == nullptr
+            || std::align(alignment, bytes, ptr, space) == nullptr) {
+        _grow(bytes + alignment);
+        ptr = _cursor;
+        space = _end - _cursor;
+        std::align(alignment, bytes, ptr, space);
+    }
+    _cursor = static_cast<char *>(ptr) + bytes;
+
+    _bytesInUse += bytes;
+    _totalBytes += bytes;
+    _peakBytes = std::max(_peakBytes, _bytesInUse);
+    _globalBytesInUse += bytes;
+    _globalTotalBytes += bytes;
+    _globalPeakBytes = std::max(_globalPeakBytes, _globalBytesInUse);
+    return ptr;
+}
+
+// Memory is only reclaimed when the whole frame goes away
+void FrameArena::do_deallocate(
+        void *ptr, std::size_t bytes, std::size_t alignment) {
+}
+
+bool FrameArena::do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+const std::size_t FrameArena::bytesInUse() const {
+    return _bytesInUse;
+}
+
+const std::size_t FrameArena::peakBytes() const {
+    return _peakBytes;
+}
+
+const std::size_t FrameArena::totalBytes() const {
+    return _totalBytes;
+}
+
+const std::size_t FrameArena::globalPeakBytes() {
+    return _globalPeakBytes;
+}
+
+const std::size_t FrameArena::globalTotalBytes() {
+    return _globalTotalBytes;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace kisslang {
+    /*
+     * Bump allocator owned by a single StackFrame.
+     *
+     * Everything the frame allocates comes out of chained blocks: its local
+     * stack buffer, its constant nodes and names, and the strings and lists
+     * inside its values (see KissValue).
+     *
+     * Deallocation is a no-op, and when the frame returns the whole chain is
+     * spliced onto a shared free list in O(1). Later frames take the first
+     * free block that fits before falling back to operator new. Blocks are
+     * never given back to the system, so the free list holds as much as the
+     * deepest run of live frames ever needed at once.
+     */
+    class FrameArena : public std::pmr::memory_resource {
+        private:
+            struct Block {
+                Block *next;
+                std::size_t size;
+            };
+
+            static Block *_freeBlocks;
+            static std::size_t _globalBytesInUse;
+            static std::size_t _globalPeakBytes;
+            static std::size_t _globalTotalBytes;
+
+            Block *_newest;
+            Block *_oldest;
+            char *_cursor;
+            char *_end;
+            std::size_t _bytesInUse;
+            std::size_t _peakBytes;
+            std::size_t _totalBytes;
+
+            void _grow(const std::size_t minBytes);
+
+        protected:
+            void *do_allocate(
+                std::size_t bytes, std::size_t alignment
+            ) override;
+            void do_deallocate(
+                void *ptr, std::size_t bytes, std::size_t alignment
+            ) override;
+            bool do_is_equal(
+                const std::pmr::memory_resource &other
+            ) const noexcept override;
+
+        public:
+            static constexpr std::size_t blockSize = 4096;
+
+            FrameArena();
+            FrameArena(const FrameArena &other) = delete;
+            FrameArena &operator=(const FrameArena &other) = delete;
+            ~FrameArena();
+
+            void release();
+
+            const std::size_t bytesInUse() const;
+            const std::size_t peakBytes() const;
+            const std::size_t totalBytes() const;
+
+            static const std::size_t globalPeakBytes();
+            static const std::size_t globalTotalBytes();
+    };
+}
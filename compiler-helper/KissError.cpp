@@ -1,44 +1,47 @@
 #include <exception>
 #include <any>
 #include <string>
+#include <KissError.hpp>
 
 using namespace kisslang;
 
-LocalStackOverflow::LocalStackUnderflow(
+LocalStackUnderflow::LocalStackUnderflow(
         const std::string localName, const std::string argString) :
-        _localName(localName), _argString(argString) {
+        _message(
+            "Error: Not enough items on stack!\n"
+            "Location: Function " + localName
+                + " called with argument " + argString + "\n"
+        ) {
 }
 
-const char *LocalStackOverflow::what() const throw() {
-    return
-        "Error: Not enough items on stack!\n"
-        "Location: Function " _localName
-        " called with argument " _argString "\n";
+const char *LocalStackUnderflow::what() const throw() {
+    return _message.c_str();
 }
 
 ConstDoesNotExist::ConstDoesNotExist(
         const std::string localName, const std::string argString,
         const std::string identifier) :
-        _localName(localName), _argString(argString), _identifier(identifier) {
+        _message(
+            "Error: Constant '" + identifier + "' has not been declared!\n"
+            "Location: Function " + localName
+                + " called with argument " + argString + "\n"
+        ) {
 }
 
 const char *ConstDoesNotExist::what() const throw() {
-    return
-        "Error: Constant '" _identifier "' has not been declared!\n"
-        "Location: Function " _localName
-        " called with argument " _argString "\n";
+    return _message.c_str();
 }
 
 ConstAlreadyExist::ConstAlreadyExist(
         const std::string localName, const std::string argString,
         const std::string identifier) :
-        _localName(localName), _argString(argString), _identifier(identifier) {
+        _message(
+            "Error: Constant '" + identifier + "' has already been declared!\n"
+            "Location: Function " + localName
+                + " called with argument " + argString + "\n"
+        ) {
 }
 
 const char *ConstAlreadyExist::what() const throw() {
-    return
-        "Error: Constant '" _identifier "' has already been declared!\n"
-        "Location: Function " _localName
-        " called with argument " _argString "\n";
+    return _message.c_str();
 }
-
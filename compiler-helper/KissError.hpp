@@ -12,8 +12,7 @@ namespace kisslang {
         const char *what() const throw();
         
         private:
-            const std::string _localName;
-            const std::string _argString;
+            const std::string _message;
     };
 
     struct ConstDoesNotExist : public std::exception {
@@ -24,9 +23,7 @@ namespace kisslang {
         const char *what() const throw();
         
         private:
-            const std::string _localName;
-            const std::string _argString;
-            const std::string _identifier;
+            const std::string _message;
     };
 
     struct ConstAlreadyExist : public std::exception {
@@ -37,8 +34,6 @@ namespace kisslang {
         const char *what() const throw();
         
         private:
-            const std::string _localName;
-            const std::string _argString;
-            const std::string _identifier;
+            const std::string _message;
     };
 }
@@ -1,59 +1,81 @@
-#include <utility>
 #include <map>
-#include <any>
+#include <deque>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <memory_resource>
 #include <KissError.hpp>
+#include <KissArena.hpp>
+#include <KissValue.hpp>
 #include <KissLang.hpp>
 
 using namespace kisslang;
 
-std::vector<StackFrame> kisslang::highestScopeStack;
+std::deque<StackFrame> kisslang::highestScopeStack;
 
-StackFrame::StackFrame(const std::string localName, const std::any _argument) :
-        _localStack(), _localConstants(), _localName(localName),
-        _input(_argument) {
+StackFrame::StackFrame(const std::string localName, const KissValue &argument) :
+        _arena(), _localStack(&_arena), _localConstants(&_arena),
+        _localName(localName), _argument(argument.copyInto(&_arena)) {
 }
 
-void StackFrame::push(const std::any value) {
-    if(value.type() == typeid(std::string(""))) {
-        try {
-            _localStack.push_back(
-                _localConstants.at(std::any_cast<std::string>(newConst));
-            );
-        } catch(std::out_of_range oor) {
-            throw new ConstDoesNotExist(_localName, _argument.type().name());
-        }
+const KissValue &StackFrame::_constant(const std::string_view name) const {
+    const auto found = _localConstants.find(name);
+    if(found == _localConstants.end()) {
+        throw new ConstDoesNotExist(
+            _localName, _argument.typeName(), std::string(name)
+        );
+    }
+    return found->second;
+}
+
+void StackFrame::push(const KissValue &value) {
+    if(const auto name = std::get_if<KissName>(&value.data())) {
+        _localStack.push_back(_constant(name->name).copyInto(&_arena));
     } else {
-        _localStack.push_back(newConst);
+        _localStack.push_back(value.copyInto(&_arena));
     }
 }
 
-const std::any StackFrame::pop() {
+/*
+ * The value still lives in this frame's arena, so it's only good until the
+ * frame returns. Use returnTo() to hand it to the caller
+ */
+KissValue StackFrame::pop() {
     if(_localStack.empty()) {
-        throw new LocalStackUnderflow(_localName, _argument.type().name());
+        throw new LocalStackUnderflow(_localName, _argument.typeName());
     }
-    
-    if(_localStack.back().type() == typeid(std::string(""))) {
-        const auto ident = _localStack.pop_back();
-        try {
-            return _localConstants.at(ident);
-        } catch(std::out_of_range oor) {
-            throw new ConstDoesNotExist(
-                _localName, _argument.type().name(),
-                any_cast<const std::string>(ident)
-            );
-        }
+
+    auto top = std::move(_localStack.back());
+    _localStack.pop_back();
+    if(const auto name = std::get_if<KissName>(&top.data())) {
+        return _constant(name->name).copyInto(&_arena);
     }
-    return _localStack.pop_back();
+    return top;
 }
 
-void StackFrame::addConst(
-        std::pair<const std::string, const std::any> newConst) {
-    auto [it, result] = _localConstants.emplace(newConst);
+/*
+ * Only the returned value survives the call, so it's rebuilt in the
+ * caller's arena and this frame's arena can be dropped as a whole
+ */
+void StackFrame::returnTo(StackFrame &caller) {
+    caller._localStack.push_back(pop().copyInto(&caller._arena));
+}
+
+void StackFrame::addConst(const std::string_view name, const KissValue &value) {
+    auto [it, result] = _localConstants.emplace(name, value.copyInto(&_arena));
     if(!result) {
         throw new ConstAlreadyExist(
-            _localName, _argument.type().name(), newConst.first
+            _localName, _argument.typeName(), std::string(name)
         );
     }
 }
+
+// For building strings and lists straight in this frame's arena
+std::pmr::memory_resource *StackFrame::resource() {
+    return &_arena;
+}
+
+const FrameArena &StackFrame::arena() const {
+    return _arena;
+}
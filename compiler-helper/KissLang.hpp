@@ -1,28 +1,46 @@
 #pragma once
 
+#include <deque>
 #include <vector>
 #include <string>
-#include <utility>
+#include <string_view>
 #include <map>
-#include <any>
+#include <functional>
+#include <memory_resource>
+#include <KissArena.hpp>
+#include <KissValue.hpp>
 
 namespace kisslang {
+    /*
+     * Everything a frame holds, values and their strings and lists included,
+     * comes out of its arena. The arena has to be declared first so the stack
+     * and constants are destroyed before their memory is handed back
+     */
     class StackFrame {
         private:
-            std::vector<const std::any> _localStack;
-            std::map<const std::string, const std::any> _localConstants;
+            FrameArena _arena;
+            std::pmr::vector<KissValue> _localStack;
+            std::pmr::map<std::pmr::string, KissValue, std::less<>>
+                _localConstants;
             const std::string _localName;
-            const std::any _argument;
-        
+            const KissValue _argument;
+
+            const KissValue &_constant(const std::string_view name) const;
+
         public:
-            StackFrame(const std::string localName, const std::any _argument);
-            
-            void addConst(
-                std::pair<const std::string, const std::any> newConst
-            );
-            void push(const std::any value);
-            const std::any pop();
+            StackFrame(const std::string localName, const KissValue &argument);
+
+            void addConst(const std::string_view name, const KissValue &value);
+            void push(const KissValue &value);
+            KissValue pop();
+            void returnTo(StackFrame &caller);
+            std::pmr::memory_resource *resource();
+            const FrameArena &arena() const;
     };
-    
-    extern std::vector<any> highestScopeStack;
+
+    /*
+     * A deque so frames never move: their containers point at their arena,
+     * and pushing a new frame must not relocate the ones below it
+     */
+    extern std::deque<StackFrame> highestScopeStack;
 }
@@ -0,0 +1,105 @@
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <stdexcept>
+#include <memory_resource>
+#include <KissValue.hpp>
+
+using namespace kisslang;
+
+static std::pmr::vector<KissValue> copyItems(
+        const std::pmr::vector<KissValue> &items,
+        std::pmr::memory_resource *resource) {
+    std::pmr::vector<KissValue> copied(resource);
+    copied.reserve(items.size());
+    for(const auto &item : items) {
+        copied.push_back(item.copyInto(resource));
+    }
+    return copied;
+}
+
+KissValue::KissValue(Data data) : _data(std::move(data)) {
+}
+
+KissValue::KissValue() : _data() {
+}
+
+KissValue::KissValue(const int value) : _data(static_cast<long long>(value)) {
+}
+
+KissValue::KissValue(const long long value) : _data(value) {
+}
+
+KissValue::KissValue(const double value) : _data(value) {
+}
+
+KissValue::KissValue(const char value) : _data(value) {
+}
+
+KissValue::KissValue(const bool value) : _data(value) {
+}
+
+KissValue::KissValue(
+        const std::string_view str, std::pmr::memory_resource *resource) :
+        _data(std::pmr::string(str, resource)) {
+}
+
+KissValue KissValue::name(
+        const std::string_view name, std::pmr::memory_resource *resource) {
+    return KissValue(Data(KissName { std::pmr::string(name, resource) }));
+}
+
+KissValue KissValue::list(std::pmr::memory_resource *resource) {
+    return KissValue(Data(KissList { std::pmr::vector<KissValue>(resource) }));
+}
+
+KissValue KissValue::tuple(
+        const KissValue &first, const KissValue &second,
+        std::pmr::memory_resource *resource) {
+    KissTuple tuple { std::pmr::vector<KissValue>(resource) };
+    tuple.items.reserve(2);
+    tuple.items.push_back(first.copyInto(resource));
+    tuple.items.push_back(second.copyInto(resource));
+    return KissValue(Data(std::move(tuple)));
+}
+
+void KissValue::append(const KissValue &item) {
+    auto list = std::get_if<KissList>(&_data);
+    if(list == nullptr) {
+        throw std::logic_error("append() on a " + typeName());
+    }
+    list->items.push_back(
+        item.copyInto(list->items.get_allocator().resource())
+    );
+}
+
+const KissValue::Data &KissValue::data() const {
+    return _data;
+}
+
+const std::string KissValue::typeName() const {
+    static const char *names[] = {
+        "none", "integer", "float", "char", "bool", "string", "name", "list",
+        "tuple"
+    };
+    return names[_data.index()];
+}
+
+// Scalars are copied as they are, everything else is rebuilt in resource
+KissValue KissValue::copyInto(std::pmr::memory_resource *resource) const {
+    if(const auto str = std::get_if<std::pmr::string>(&_data)) {
+        return KissValue(Data(std::pmr::string(*str, resource)));
+    } else if(const auto name = std::get_if<KissName>(&_data)) {
+        return KissValue(Data(KissName {
+            std::pmr::string(name->name, resource)
+        }));
+    } else if(const auto list = std::get_if<KissList>(&_data)) {
+        return KissValue(Data(KissList { copyItems(list->items, resource) }));
+    } else if(const auto tuple = std::get_if<KissTuple>(&_data)) {
+        return KissValue(Data(KissTuple {
+            copyItems(tuple->items, resource)
+        }));
+    }
+    return KissValue(_data);
+}
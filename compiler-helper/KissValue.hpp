@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <memory_resource>
+
+namespace kisslang {
+    class KissValue;
+
+    // Pushing one of these pushes the value of the constant it names instead
+    struct KissName {
+        std::pmr::string name;
+    };
+
+    struct KissList {
+        std::pmr::vector<KissValue> items;
+    };
+
+    // Always exactly two items
+    struct KissTuple {
+        std::pmr::vector<KissValue> items;
+    };
+
+    /*
+     * A value on a frame's stack.
+     *
+     * Strings, lists and tuples keep their payload in the memory resource
+     * they were built with, so a frame builds its values in its own arena and
+     * copyInto() rebuilds one in another resource before that arena goes away.
+     * Plain copies follow std::pmr and land on the default resource, so the
+     * frame code always goes through copyInto()
+     */
+    class KissValue {
+        public:
+            using Data = std::variant<
+                std::monostate, long long, double, char, bool,
+                std::pmr::string, KissName, KissList, KissTuple
+            >;
+
+        private:
+            Data _data;
+
+            explicit KissValue(Data data);
+
+        public:
+            KissValue();
+            explicit KissValue(const int value);
+            explicit KissValue(const long long value);
+            explicit KissValue(const double value);
+            explicit KissValue(const char value);
+            explicit KissValue(const bool value);
+            KissValue(
+                const std::string_view str, std::pmr::memory_resource *resource
+            );
+
+            static KissValue name(
+                const std::string_view name,
+                std::pmr::memory_resource *resource
+            );
+            static KissValue list(std::pmr::memory_resource *resource);
+            static KissValue tuple(
+                const KissValue &first, const KissValue &second,
+                std::pmr::memory_resource *resource
+            );
+
+            // Lists only, the item is copied into the list's resource
+            void append(const KissValue &item);
+
+            const Data &data() const;
+            const std::string typeName() const;
+            KissValue copyInto(std::pmr::memory_resource *resource) const;
+    };
+}
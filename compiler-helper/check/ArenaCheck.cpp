@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <variant>
+#include <KissArena.hpp>
+#include <KissValue.hpp>
+#include <KissLang.hpp>
+
+using namespace kisslang;
+
+/*
+ * Built and run by `make check-helper`.
+ * Exits non-zero on the first counter that doesn't add up
+ */
+static int failures = 0;
+
+static void expect(const bool condition, const std::string &what) {
+    if(!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+int main() {
+    auto &caller = highestScopeStack.emplace_back("main", KissValue());
+    auto &callee = highestScopeStack.emplace_back("square", KissValue(3));
+
+    for(int i = 0; i < 1000; i++) {
+        callee.push(KissValue(i));
+    }
+    callee.addConst("answer", KissValue(42));
+    expect(callee.arena().bytesInUse() > 0, "frame allocates from its arena");
+    expect(
+        callee.arena().totalBytes() >= 1000 * sizeof(KissValue),
+        "totalBytes counts every push"
+    );
+    expect(
+        callee.arena().peakBytes() == callee.arena().bytesInUse(),
+        "peakBytes tracks the high-water mark"
+    );
+
+    callee.push(KissValue::name("answer", callee.resource()));
+    callee.returnTo(caller);
+    expect(
+        std::get<long long>(caller.pop().data()) == 42,
+        "returnTo hands the constant's value to the caller"
+    );
+
+    // Payloads come from the arena too, and survive the callee's arena
+    const std::string text(1000, 'k');
+    const auto beforeString = callee.arena().bytesInUse();
+    auto list = KissValue::list(callee.resource());
+    list.append(KissValue(text, callee.resource()));
+    list.append(KissValue(text, callee.resource()));
+    callee.push(list);
+    expect(
+        callee.arena().bytesInUse() >= beforeString + 4 * text.length(),
+        "strings inside a list are built in the frame's arena"
+    );
+    const auto callerBefore = caller.arena().bytesInUse();
+    callee.returnTo(caller);
+    expect(
+        caller.arena().bytesInUse() >= callerBefore + 2 * text.length(),
+        "returnTo rebuilds the value in the caller's arena"
+    );
+
+    const auto peak = callee.arena().peakBytes();
+    const auto globalTotal = FrameArena::globalTotalBytes();
+    highestScopeStack.pop_back();
+    expect(
+        &highestScopeStack.back() == &caller,
+        "frames below the top never move"
+    );
+
+    const auto returned = caller.pop();
+    const auto &items = std::get<KissList>(returned.data()).items;
+    expect(
+        items.size() == 2 && items[1].typeName() == "string"
+            && std::get<std::pmr::string>(items[1].data()) == text.c_str(),
+        "the returned list outlives the callee"
+    );
+    expect(
+        items.get_allocator().resource() == caller.resource(),
+        "the returned list points at the caller's arena"
+    );
+
+    FrameArena arena;
+    static_cast<void>(arena.allocate(FrameArena::blockSize * 2));
+    static_cast<void>(arena.allocate(16));
+    expect(arena.bytesInUse() == FrameArena::blockSize * 2 + 16, "bytesInUse");
+    arena.release();
+    expect(arena.bytesInUse() == 0, "release() empties the arena");
+    expect(
+        arena.peakBytes() == FrameArena::blockSize * 2 + 16,
+        "release() keeps the peak"
+    );
+    static_cast<void>(arena.allocate(FrameArena::blockSize * 2));
+    expect(
+        arena.bytesInUse() == FrameArena::blockSize * 2, "reuse after release"
+    );
+    expect(
+        FrameArena::globalPeakBytes() >= peak,
+        "global peak covers every frame"
+    );
+    expect(
+        FrameArena::globalTotalBytes() > globalTotal,
+        "global total keeps counting"
+    );
+
+    if(failures == 0) {
+        std::cout << "Arena checks passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
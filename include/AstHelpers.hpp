@@ -0,0 +1,284 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <set>
+#include <utility>
+#include <stdexcept>
+#include <cctype>
+#include <Error.hpp>
+#include <Token.hpp>
+
+namespace kisslang {
+    inline const std::shared_ptr<SymbolToken> firstSymbol(
+            const std::shared_ptr<Token> &token) {
+        std::shared_ptr<Token> currToken = token;
+        while(!currToken->isSymbol()) {
+            currToken = std::dynamic_pointer_cast<CompoundToken>(
+                currToken
+            )->children[0];
+        }
+        return std::dynamic_pointer_cast<SymbolToken>(currToken);
+    }
+
+    inline const std::shared_ptr<CompoundToken> asCompound(
+            const std::shared_ptr<Token> &token) {
+        return std::dynamic_pointer_cast<CompoundToken>(token);
+    }
+
+    inline const std::shared_ptr<SymbolToken> asSymbol(
+            const std::shared_ptr<Token> &token) {
+        return std::dynamic_pointer_cast<SymbolToken>(token);
+    }
+
+    inline const bool isSymbolOf(
+            const std::shared_ptr<Token> &token, const SymbolTokenType &type,
+            const std::string &value) {
+        return token->isSymbol() && asSymbol(token)->type == type
+            && asSymbol(token)->value == value;
+    }
+
+    inline const bool isCompoundOf(
+            const std::shared_ptr<Token> &token,
+            const CompoundTokenType &type) {
+        return !token->isSymbol() && asCompound(token)->type == type;
+    }
+
+    // The symbol inside a literal statement like 99:1 or nullptr if it isn't one
+    inline const std::shared_ptr<SymbolToken> rawLiteral(
+            const std::shared_ptr<Token> &token) {
+        if(!isCompoundOf(token, CompoundTokenType::Type)) {
+            return nullptr;
+        }
+        const auto raw = asCompound(token)->children[0];
+        if(!isCompoundOf(raw, CompoundTokenType::RawType)) {
+            return nullptr;
+        }
+        return asSymbol(asCompound(raw)->children[0]);
+    }
+
+    // The string literal in a statement like 'lib' or nullptr if it isn't one
+    inline const std::shared_ptr<SymbolToken> stringLiteral(
+            const std::shared_ptr<Token> &token) {
+        const auto symbol = rawLiteral(token);
+        return symbol && symbol->type == SymbolTokenType::String ?
+            symbol : nullptr;
+    }
+
+    inline const std::string unescape(const std::string &str) {
+        std::string result;
+        for(std::size_t i = 0; i < str.length(); i++) {
+            if(str[i] != '\\' || i + 1 == str.length()) {
+                result += str[i];
+                continue;
+            }
+            i++;
+            switch(str[i]) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case '0': result += '\0'; break;
+                default: result += str[i]; break;
+            }
+        }
+        return result;
+    }
+
+    // Wrap into the declared byte width like a C cast would
+    inline const long long wrapInteger(
+            const unsigned long long &value, const int &size) {
+        const auto bits = size * 8;
+        if(bits >= 64) {
+            return static_cast<long long>(value);
+        }
+        auto wrapped = value & ((1ULL << bits) - 1);
+        if(wrapped & (1ULL << (bits - 1))) {
+            wrapped |= ~((1ULL << bits) - 1);
+        }
+        return static_cast<long long>(wrapped);
+    }
+
+    // Integer literals look like 99:1, 0x1F:4 or 0b101:2
+    inline const long long parseInteger(const SymbolToken &token, int &size) {
+        const auto colon = token.value.rfind(':');
+        const auto digits = token.value.substr(0, colon);
+        size = token.value[colon + 1] - '0';
+
+        int base = 10;
+        std::size_t start = 0;
+        if(digits.length() > 2 && digits[0] == '0'
+                && (digits[1] == 'x' || digits[1] == 'b')) {
+            base = digits[1] == 'x' ? 16 : 2;
+            start = 2;
+        }
+
+        // stoull would also take a sign or leading spaces
+        std::size_t used = 0;
+        unsigned long long value = 0;
+        if(start < digits.length() && std::isxdigit(
+                static_cast<unsigned char>(digits[start]))) {
+            try {
+                value = std::stoull(digits.substr(start), &used, base);
+            } catch(const std::logic_error &le) {
+                used = 0;
+            }
+        }
+        if(used == 0 || used != digits.length() - start) {
+            throw TypeException(token, "Invalid integer literal");
+        }
+
+        return wrapInteger(value, size);
+    }
+
+    /*
+     * A literal the lexer could have read for value, so negative numbers
+     * are written as their two's complement in hex, e.g. -1 as 0xFF:1
+     */
+    inline const std::string integerLiteral(
+            const long long &value, const int &size) {
+        if(value >= 0) {
+            return std::to_string(value) + ":" + std::to_string(size);
+        }
+        auto bits = static_cast<unsigned long long>(value);
+        if(size < 8) {
+            bits &= (1ULL << (size * 8)) - 1;
+        }
+        std::string hex;
+        for(; bits != 0; bits >>= 4) {
+            hex = "0123456789ABCDEF"[bits & 0xF] + hex;
+        }
+        return "0x" + hex + ":" + std::to_string(size);
+    }
+
+    // A <type-name> written back out the way it's spelled, e.g. (#:1 [@])
+    inline const std::string typeNameStr(const std::shared_ptr<Token> &token) {
+        const auto &children = asCompound(token)->children;
+        const auto first = asSymbol(children[0]);
+        if(children.size() == 1) {
+            return first->value;
+        } else if(first->type == SymbolTokenType::Dollar) {
+            return "$" + asSymbol(children[1])->value;
+        } else if(first->type == SymbolTokenType::Bracket) {
+            return "[" + typeNameStr(children[1]) + "]";
+        }
+        return "(" + typeNameStr(children[1]) + " " + typeNameStr(children[2])
+            + ")";
+    }
+
+    /*
+     * The type name of a literal statement like 99:1, [0c1 0c2] or (1:1 'a'),
+     * or "" if it doesn't have one on its own
+     */
+    inline const std::string literalTypeName(
+            const std::shared_ptr<Token> &token) {
+        if(!isCompoundOf(token, CompoundTokenType::Type)) {
+            return "";
+        }
+        const auto value = asCompound(asCompound(token)->children[0]);
+        const auto &children = value->children;
+        if(value->type == CompoundTokenType::RawType) {
+            const auto symbol = asSymbol(children[0]);
+            const auto size = symbol->value.substr(symbol->value.length() - 1);
+            switch(symbol->type) {
+                case SymbolTokenType::Integer: return "#:" + size;
+                case SymbolTokenType::Float: return ".:" + size;
+                case SymbolTokenType::Character: return "@";
+                case SymbolTokenType::Boolean: return "?";
+                case SymbolTokenType::String: return "[@]";
+                default: return "";
+            }
+        } else if(value->type == CompoundTokenType::Tuple) {
+            const auto first = literalTypeName(children[1]);
+            const auto second = literalTypeName(children[2]);
+            return first == "" || second == "" ?
+                "" : "(" + first + " " + second + ")";
+        } else if(value->type == CompoundTokenType::List) {
+            const auto item = literalTypeName(children[1]);
+            for(std::size_t i = 2; i < children.size() - 1; i++) {
+                if(literalTypeName(children[i]) != item) {
+                    return "";
+                }
+            }
+            return item == "" ? "" : "[" + item + "]";
+        }
+        return "";
+    }
+
+    inline const std::shared_ptr<Token> makeLiteral(
+            const SymbolTokenType &type, const std::string &value,
+            const std::pair<int, int> &position) {
+        const auto symbol = std::make_shared<SymbolToken>(
+            type, value, position
+        );
+        const auto raw = std::make_shared<CompoundToken>(
+            CompoundTokenType::RawType,
+            std::vector<std::shared_ptr<Token>>({ symbol })
+        );
+        return std::make_shared<CompoundToken>(
+            CompoundTokenType::Type,
+            std::vector<std::shared_ptr<Token>>({ raw })
+        );
+    }
+
+    // 'lib' import
+    inline const bool isImport(
+            const std::vector<std::shared_ptr<Token>> &stmts,
+            const std::size_t &index) {
+        return index + 1 < stmts.size() && stringLiteral(stmts[index])
+            && isSymbolOf(
+                stmts[index + 1], SymbolTokenType::Identifier, "import"
+            );
+    }
+
+    /*
+     * How many top-level statements starting at index make up a definition:
+     *  - func name :: T -> T { ... }   (one FuncDef)
+     *  - name struct { ... }           (identifier + StructDef)
+     *  - <value> name =                (literal, identifier, assignment)
+     * Zero means the statement is not a definition
+     */
+    inline const std::size_t definitionLength(
+            const std::vector<std::shared_ptr<Token>> &stmts,
+            const std::size_t &index) {
+        if(isCompoundOf(stmts[index], CompoundTokenType::FuncDef)) {
+            return 1;
+        } else if(index + 1 < stmts.size() && stmts[index]->isSymbol()
+                && asSymbol(stmts[index])->type == SymbolTokenType::Identifier
+                && isCompoundOf(stmts[index + 1], CompoundTokenType::StructDef)) {
+            return 2;
+        } else if(index + 2 < stmts.size()
+                && isCompoundOf(stmts[index], CompoundTokenType::Type)
+                && stmts[index + 1]->isSymbol()
+                && asSymbol(stmts[index + 1])->type
+                    == SymbolTokenType::Identifier
+                && isSymbolOf(stmts[index + 2], SymbolTokenType::Operator, "=")) {
+            return 3;
+        }
+        return 0;
+    }
+
+    inline const std::shared_ptr<SymbolToken> definedName(
+            const std::vector<std::shared_ptr<Token>> &stmts,
+            const std::size_t &index) {
+        if(isCompoundOf(stmts[index], CompoundTokenType::FuncDef)) {
+            return asSymbol(asCompound(stmts[index])->children[1]);
+        } else if(stmts[index]->isSymbol()) {
+            return asSymbol(stmts[index]);
+        }
+        return asSymbol(stmts[index + 1]);
+    }
+
+    inline void collectIdentifiers(
+            const std::shared_ptr<Token> &token, std::set<std::string> &names) {
+        if(token->isSymbol()) {
+            if(asSymbol(token)->type == SymbolTokenType::Identifier) {
+                names.insert(asSymbol(token)->value);
+            }
+            return;
+        }
+        for(const auto &child : asCompound(token)->children) {
+            collectIdentifiers(child, names);
+        }
+    }
+}
@@ -7,12 +7,16 @@
 namespace kisslang {
     struct SmoochException : public std::exception {
         SmoochException(std::string message, int line, int col);
+        // The same error, but naming the file it was found in
+        SmoochException(const SmoochException &inner, std::string fileName);
         ~SmoochException();
         const char *what() const throw();
         protected:
             std::string _message;
             int _line, _col;
             char *_whatStr;
+            
+            void _setWhat(const std::string &where);
     };
     
     struct UnknownTokenException : public SmoochException {
@@ -22,4 +26,16 @@ namespace kisslang {
     struct UnexpectedTokenException : public SmoochException {
         UnexpectedTokenException(const SymbolToken &token, std::string tokStr);
     };
+    
+    struct TypeException : public SmoochException {
+        TypeException(const SymbolToken &token, std::string message);
+    };
+    
+    struct UnsupportedException : public SmoochException {
+        UnsupportedException(const SymbolToken &token, std::string what);
+    };
+    
+    struct ImportException : public SmoochException {
+        ImportException(const SymbolToken &token, std::string fileName);
+    };
 }
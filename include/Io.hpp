@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <map>
+#include <utility>
 
 /*
  * This is a set of helper functions for the main function
@@ -8,9 +10,24 @@
  */
 namespace kisslang {
     namespace Io {
+        struct Options {
+            bool native;
+            bool instrument;
+            int inlineThreshold;
+            std::string profileFileName;
+        };
+        
         const int sourceCodeFromArgs(
-            std::string &code, std::string &moduleName,
+            std::string &code, std::string &moduleName, Options &options,
             int argc, char **args
         );
+        const int readSourceFile(const std::string &fileName, std::string &code);
+        const std::string moduleFileName(const std::string &moduleName);
+        const std::string outputFileName(const std::string &moduleName);
+        const int readProfile(
+            const std::string &fileName,
+            std::map<std::pair<std::string, std::string>, long long>
+                &callCounts
+        );
     }
 }
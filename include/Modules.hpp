@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <Token.hpp>
+
+/*
+ * Resolves 'name' import statements.
+ * Imported modules only contribute their definitions (funcs, structs and
+ * constants); any other top-level statement in them is left out
+ */
+namespace kisslang {
+    namespace Modules {
+        /*
+         * Which file each linked definition came from, keyed by the token
+         * naming it. Everything else came from the main module's file
+         */
+        struct SourceMap {
+            std::string mainFileName;
+            std::map<const SymbolToken *, std::string> definitionFiles;
+            
+            const std::string &fileOf(
+                const std::shared_ptr<SymbolToken> &name
+            ) const;
+        };
+        
+        // The same file always gets the same name, wherever it's named from
+        const std::string canonicalFileName(const std::string &fileName);
+        
+        const CompoundToken link(
+            const CompoundToken &ast, const std::string &mainFileName,
+            SourceMap &sources
+        );
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <Token.hpp>
+#include <Modules.hpp>
+
+/*
+ * Backend that skips the C++ compiler entirely.
+ * The AST is lowered straight to x86-64 assembly for Linux, which is then
+ * run through the system assembler and linker together with the runtime.
+ * Given a profile file name, the program counts and times every func and
+ * loop and writes the results there when it exits
+ */
+namespace kisslang {
+    namespace Native {
+        const std::string generateAssembly(
+            const CompoundToken &ast, const Modules::SourceMap &sources,
+            const std::string &profileFileName
+        );
+        const int assemble(
+            const std::string &outputFileName, const std::string &asmCode
+        );
+        const std::string runtimeAssembly();
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <Error.hpp>
+#include <Token.hpp>
+#include <AstHelpers.hpp>
+
+namespace kisslang {
+    /*
+     * [@] is Str since strings keep their bytes packed, any other list is
+     * List. Spread is what unzip leaves behind: the items of a list followed
+     * by how many there are, which only zip knows how to take back
+     */
+    enum class KissKind {
+        Int,    Char,   Bool,   Str,
+        List,   Tuple,  Spread
+    };
+
+    // What the native backend knows about a value sitting on the data stack
+    struct KissType {
+        KissKind kind;
+        int size;
+        std::vector<KissType> inner;
+
+        const bool operator==(const KissType &other) const {
+            return kind == other.kind && size == other.size
+                && inner == other.inner;
+        }
+        const bool operator!=(const KissType &other) const {
+            return !(*this == other);
+        }
+
+        const std::string str() const {
+            switch(kind) {
+                case KissKind::Int:
+                    return "#:" + std::to_string(size);
+                case KissKind::Char:
+                    return "@";
+                case KissKind::Bool:
+                    return "?";
+                case KissKind::Str:
+                    return "[@]";
+                case KissKind::List:
+                    return "[" + inner[0].str() + "]";
+                case KissKind::Tuple:
+                    return "(" + inner[0].str() + " " + inner[1].str() + ")";
+                default:
+                    return inner[0].str() + " unzipped";
+            }
+        }
+    };
+
+    inline const bool isList(const KissType &type) {
+        return type.kind == KissKind::Str || type.kind == KissKind::List;
+    }
+
+    inline const KissType listOf(const KissType &item) {
+        if(item.kind == KissKind::Char) {
+            return { KissKind::Str, 8 };
+        }
+        return { KissKind::List, 8, { item } };
+    }
+
+    inline const KissType itemOf(const KissType &list) {
+        if(list.kind == KissKind::Str) {
+            return { KissKind::Char, 1 };
+        }
+        return list.inner[0];
+    }
+
+    // Bytes per item in a list's storage
+    inline const int itemWidth(const KissType &list) {
+        return list.kind == KissKind::Str ? 1 : 8;
+    }
+
+    // Turns a <type-name> token into a type, e.g. #:4, [@] or (#:1 [@])
+    inline const KissType typeFromTypeName(
+            const std::shared_ptr<CompoundToken> &typeName) {
+        const auto first = asSymbol(typeName->children[0]);
+        if(typeName->children.size() == 1) {
+            if(first->value == "@") {
+                return { KissKind::Char, 1 };
+            } else if(first->value == "?") {
+                return { KissKind::Bool, 1 };
+            } else if(first->value[0] == '#') {
+                return { KissKind::Int, first->value[2] - '0' };
+            }
+        } else if(first->type == SymbolTokenType::Bracket) {
+            return listOf(typeFromTypeName(asCompound(typeName->children[1])));
+        } else if(first->type == SymbolTokenType::Parenth) {
+            return {
+                KissKind::Tuple, 8, {
+                    typeFromTypeName(asCompound(typeName->children[1])),
+                    typeFromTypeName(asCompound(typeName->children[2]))
+                }
+            };
+        }
+        throw UnsupportedException(*first, "type name");
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <Token.hpp>
+#include <Modules.hpp>
+
+/*
+ * Whole program passes run on the linked AST before code generation.
+ * Each one returns the new program and appends what it did to the report
+ */
+namespace kisslang {
+    namespace Optimizer {
+        const CompoundToken eliminateDeadCode(
+            const CompoundToken &program, const Modules::SourceMap &sources,
+            std::vector<std::string> &report
+        );
+        const CompoundToken inlineCalls(
+            const CompoundToken &program, const int &threshold,
+            const std::map<std::pair<std::string, std::string>, long long>
+                &callCounts,
+            const Modules::SourceMap &sources,
+            std::vector<std::string> &report
+        );
+    }
+}
@@ -2,7 +2,6 @@
 
 #include <string>
 #include <vector>
-#include <regex>
 #include <map>
 #include <Token.hpp>
 
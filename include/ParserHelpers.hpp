@@ -3,7 +3,6 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <regex>
 #include <Error.hpp>
 #include <Token.hpp>
 
@@ -20,30 +19,6 @@ namespace kisslang {
         return false;
     }
 
-    // The following two are the same idea, but work a bit differently with state
-    inline const std::string matchRegEx(
-            const std::string &regexStr, const std::string &currStr,
-            bool &foundMatches) {
-        std::smatch matches;
-        const std::regex currRegex(regexStr);
-        foundMatches = std::regex_search(currStr, matches, currRegex);
-        return matches[0].str();
-    }
-
-    inline const bool matchRegex(
-            const std::string &regexStr, const std::string &currStr,
-            std::string &matchStr) {
-        std::smatch matches;
-        const std::regex currRegex(regexStr);
-        bool foundMatches = std::regex_search(currStr, matches, currRegex);
-        matchStr = matches[0].str();
-        return foundMatches;
-    }
-
-    inline const bool startswith(const std::string &str, const std::string &what) {
-        return str.rfind(what, 0) == 0;
-    }
-
     inline const long int nonStatementIndex(const std::string &str) {
         for(long int ind = 0; ind < static_cast<long int>(str.length()); ind++) {
             const auto chr = str[ind];
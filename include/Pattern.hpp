@@ -0,0 +1,270 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+/*
+ * Regular expressions compiled while smooch itself is being compiled.
+ *
+ * compilePattern turns the subset of regex syntax the grammar tables use
+ * (literals, \ escapes, ., [classes], groups, |, *, + and ?) into a small
+ * backtracking program. That happens in a constexpr context, so nothing is
+ * built at startup and matching never allocates.
+ *
+ * Alternatives are tried left to right and quantifiers are greedy, which is
+ * the same match std::regex's ECMAScript grammar picks. Parser.cpp pins the
+ * lexer tables with static_asserts and make check-patterns compares the
+ * engine against std::regex on generated input.
+ */
+namespace kisslang {
+    struct CharSet {
+        std::uint64_t bits[4];
+
+        constexpr void add(const unsigned char chr) {
+            bits[chr / 64] |= 1ULL << (chr % 64);
+        }
+
+        constexpr void invert() {
+            for(auto &word : bits) {
+                word = ~word;
+            }
+        }
+
+        constexpr bool has(const unsigned char chr) const {
+            return (bits[chr / 64] >> (chr % 64)) & 1;
+        }
+    };
+
+    enum class PatternOp : std::uint8_t {
+        Set,    Split,  Jump,   Match
+    };
+
+    /*
+     * Set consumes one character from set.
+     * Split tries x first and falls back to y, Jump goes to x
+     */
+    struct PatternInst {
+        PatternOp op;
+        std::uint8_t x, y;
+        CharSet set;
+    };
+
+    constexpr std::size_t maxPatternLength = 96;
+
+    struct Pattern {
+        std::array<PatternInst, maxPatternLength> program;
+        std::size_t length;
+    };
+
+    class PatternCompiler {
+        private:
+            const char *_src;
+            std::size_t _pos;
+            Pattern _pattern;
+
+            constexpr char _peek() const {
+                return _src[_pos];
+            }
+
+            constexpr std::size_t _emit(
+                    const PatternOp op, const std::size_t x = 0,
+                    const std::size_t y = 0, const CharSet set = CharSet {}) {
+                if(_pattern.length == maxPatternLength) {
+                    throw std::length_error("Pattern too long");
+                }
+                auto &inst = _pattern.program[_pattern.length];
+                inst.op = op;
+                inst.x = static_cast<std::uint8_t>(x);
+                inst.y = static_cast<std::uint8_t>(y);
+                inst.set = set;
+                return _pattern.length++;
+            }
+
+            // Makes room for a Split in front of code that's already emitted
+            constexpr void _insertSplit(const std::size_t start) {
+                _emit(PatternOp::Match);
+                for(auto i = _pattern.length - 1; i > start; i--) {
+                    _pattern.program[i] = _pattern.program[i - 1];
+                    auto &inst = _pattern.program[i];
+                    if(inst.op == PatternOp::Split || inst.op == PatternOp::Jump) {
+                        inst.x += inst.x >= start ? 1 : 0;
+                        inst.y += inst.y >= start ? 1 : 0;
+                    }
+                }
+                _pattern.program[start] = PatternInst {
+                    PatternOp::Split, 0, 0, CharSet {}
+                };
+            }
+
+            constexpr unsigned char _escaped() {
+                if(_peek() == '\\') {
+                    _pos++;
+                }
+                return static_cast<unsigned char>(_src[_pos++]);
+            }
+
+            constexpr CharSet _parseClass() {
+                CharSet set {};
+                _pos++;
+                const bool negate = _peek() == '^';
+                if(negate) {
+                    _pos++;
+                }
+                while(_peek() != ']') {
+                    if(_peek() == '\0') {
+                        throw std::invalid_argument("Unclosed [");
+                    }
+                    const auto first = _escaped();
+                    if(_peek() == '-' && _src[_pos + 1] != ']') {
+                        _pos++;
+                        const auto last = _escaped();
+                        for(unsigned chr = first; chr <= last; chr++) {
+                            set.add(static_cast<unsigned char>(chr));
+                        }
+                    } else {
+                        set.add(first);
+                    }
+                }
+                _pos++;
+                if(negate) {
+                    set.invert();
+                }
+                return set;
+            }
+
+            constexpr void _parseAtom() {
+                CharSet set {};
+                switch(_peek()) {
+                    case '(':
+                        _pos++;
+                        _parseAlternation();
+                        if(_peek() != ')') {
+                            throw std::invalid_argument("Unclosed (");
+                        }
+                        _pos++;
+                        return;
+                    case '[':
+                        set = _parseClass();
+                        break;
+                    case '.':
+                        _pos++;
+                        set.add('\n');
+                        set.add('\r');
+                        set.invert();
+                        break;
+                    default:
+                        set.add(_escaped());
+                        break;
+                }
+                _emit(PatternOp::Set, 0, 0, set);
+            }
+
+            constexpr void _parseRepeat() {
+                const auto start = _pattern.length;
+                _parseAtom();
+                while(_peek() == '*' || _peek() == '+' || _peek() == '?') {
+                    const auto op = _src[_pos++];
+                    if(op == '+') {
+                        const auto split = _emit(PatternOp::Split, start);
+                        _pattern.program[split].y = split + 1;
+                        continue;
+                    }
+
+                    _insertSplit(start);
+                    if(op == '*') {
+                        _emit(PatternOp::Jump, start);
+                    }
+                    _pattern.program[start].x = start + 1;
+                    _pattern.program[start].y = _pattern.length;
+                }
+            }
+
+            constexpr void _parseAlternation() {
+                const auto start = _pattern.length;
+                while(_peek() != '\0' && _peek() != '|' && _peek() != ')') {
+                    _parseRepeat();
+                }
+                if(_peek() != '|') {
+                    return;
+                }
+
+                _pos++;
+                _insertSplit(start);
+                const auto jump = _emit(PatternOp::Jump);
+                const auto other = _pattern.length;
+                _parseAlternation();
+                _pattern.program[start].x = start + 1;
+                _pattern.program[start].y = other;
+                _pattern.program[jump].x = _pattern.length;
+            }
+
+        public:
+            constexpr PatternCompiler(const char *src) :
+                    _src(src), _pos(0), _pattern {} {
+            }
+
+            constexpr Pattern compile() {
+                _parseAlternation();
+                if(_peek() != '\0') {
+                    throw std::invalid_argument("Unbalanced )");
+                }
+                _emit(PatternOp::Match);
+                return _pattern;
+            }
+    };
+
+    constexpr Pattern compilePattern(const char *src) {
+        return PatternCompiler(src).compile();
+    }
+
+    // Where the match starting exactly at cur ends, or nullptr
+    constexpr const char *matchPattern(
+            const Pattern &pattern, const char *cur, const char *end,
+            std::size_t pc = 0) {
+        while(true) {
+            const auto &inst = pattern.program[pc];
+            switch(inst.op) {
+                case PatternOp::Set:
+                    if(cur == end
+                            || !inst.set.has(static_cast<unsigned char>(*cur))) {
+                        return nullptr;
+                    }
+                    cur++;
+                    pc++;
+                    break;
+                case PatternOp::Split: {
+                    const auto found = matchPattern(pattern, cur, end, inst.x);
+                    if(found != nullptr) {
+                        return found;
+                    }
+                    pc = inst.y;
+                } break;
+                case PatternOp::Jump:
+                    pc = inst.x;
+                    break;
+                case PatternOp::Match:
+                    return cur;
+            }
+        }
+    }
+
+    // The leftmost match anywhere in str, like std::regex_search
+    inline const bool searchPattern(
+            const Pattern &pattern, const std::string &str,
+            std::size_t &matchStart, std::size_t &matchLength) {
+        const auto begin = str.data();
+        const auto end = begin + str.length();
+        for(auto cur = begin; cur != end; ++cur) {
+            const auto found = matchPattern(pattern, cur, end);
+            if(found != nullptr) {
+                matchStart = cur - begin;
+                matchLength = found - cur;
+                return true;
+            }
+        }
+        return false;
+    }
+}
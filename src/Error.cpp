@@ -7,9 +7,19 @@ using namespace kisslang;
 
 SmoochException::SmoochException(std::string message, int line, int col) :
         _message(message), _line(line), _col(col) {
+    _setWhat("");
+}
+
+SmoochException::SmoochException(
+        const SmoochException &inner, std::string fileName) :
+        _message(inner._message), _line(inner._line), _col(inner._col) {
+    _setWhat(" in " + fileName);
+}
+
+void SmoochException::_setWhat(const std::string &where) {
     const auto exceptionStr =
-        "Smooch Exception '" + message + "' at line " + std::to_string(line)
-        + ", col " + std::to_string(col);
+        "Smooch Exception '" + _message + "'" + where + " at line "
+        + std::to_string(_line) + ", col " + std::to_string(_col);
     const char *exceptionCStr = exceptionStr.c_str();
     
     _whatStr = new char[exceptionStr.length() + 1];
@@ -36,3 +46,26 @@ UnexpectedTokenException::UnexpectedTokenException(
             token.position.first, token.position.second
         ) {
 }
+
+TypeException::TypeException(const SymbolToken &token, std::string message) :
+        SmoochException(
+            "Type error at \"" + token.value + "\": " + message,
+            token.position.first, token.position.second
+        ) {
+}
+
+UnsupportedException::UnsupportedException(
+        const SymbolToken &token, std::string what) :
+        SmoochException(
+            "Not supported by the native backend: " + what,
+            token.position.first, token.position.second
+        ) {
+}
+
+ImportException::ImportException(
+        const SymbolToken &token, std::string fileName) :
+        SmoochException(
+            "Could not import module \"" + fileName + "\"",
+            token.position.first, token.position.second
+        ) {
+}
@@ -1,4 +1,6 @@
+#include <cstdlib>
 #include <string>
+#include <map>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -10,8 +12,22 @@ using namespace kisslang;
 
 inline const bool isRegularFile(const std::string &path) {
     struct stat pathStat;
-    stat(path.c_str(), &pathStat);
-    return S_ISREG(pathStat.st_mode);
+    return stat(path.c_str(), &pathStat) == 0 && S_ISREG(pathStat.st_mode);
+}
+
+inline const bool isDirectory(const std::string &path) {
+    struct stat pathStat;
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+}
+
+inline const bool startsWith(const std::string &str, const std::string &what) {
+    return str.rfind(what, 0) == 0;
+}
+
+// Only plain digits, so no sign, spaces or trailing junk
+inline const bool isNumber(const std::string &str) {
+    return !str.empty() && str.length() < 10
+        && str.find_first_not_of("0123456789") == std::string::npos;
 }
 
 inline const std::string replace(
@@ -26,39 +42,69 @@ inline const std::string replace(
 }
 
 const int Io::sourceCodeFromArgs(
-        std::string &code, std::string &moduleName,
+        std::string &code, std::string &moduleName, Options &options,
         int argc, char **args) {
-    // Check for file/module name given
-    if(argc < 2) {
+    moduleName = "";
+    code = "";
+    options.native = false;
+    options.instrument = false;
+    options.inlineThreshold = 8;
+    options.profileFileName = "";
+    
+    // Split options from the file/module name
+    const char *fileName = nullptr;
+    for(int i = 1; i < argc; i++) {
+        const auto arg = std::string(args[i]);
+        if(arg == "--native") {
+            options.native = true;
+        } else if(arg == "--instrument") {
+            options.instrument = true;
+        } else if(startsWith(arg, "--profile=")) {
+            options.profileFileName = arg.substr(
+                std::string("--profile=").length()
+            );
+        } else if(startsWith(arg, "--inline-threshold=")
+                && isNumber(arg.substr(
+                    std::string("--inline-threshold=").length()
+                ))) {
+            options.inlineThreshold = std::atoi(
+                arg.substr(std::string("--inline-threshold=").length()).c_str()
+            );
+        } else if(startsWith(arg, "--")) {
+            std::cout << "Unknown option: " << arg << std::endl;
+            return -1;
+        } else if(fileName != nullptr) {
+            std::cout << "Too many arguments given!" << std::endl;
+            return -1;
+        } else {
+            fileName = args[i];
+        }
+    }
+    
+    if(fileName == nullptr) {
         std::cout << "No file name provided." << std::endl;
-        moduleName = "";
-        code = "";
         return -1;
     }
     
-    if(argc > 2) {
-        std::cout << "Too many arguments given!" << std::endl;
-        moduleName = "";
-        code = "";
+    if(options.instrument && !options.native) {
+        std::cout << "--instrument needs the --native backend." << std::endl;
         return -1;
     }
     
     // Check if a valid file name or module name
-    std::ifstream srcFile(args[1]);
-    bool isFile = srcFile.good() && isRegularFile(args[1]);
+    std::ifstream srcFile(fileName);
+    bool isFile = srcFile.good() && isRegularFile(fileName);
     bool isDir = false;
     if(!isFile) {
         srcFile.close();
         
         std::stringstream moduleFileName;
-        moduleFileName << args[1] << "/main.kiss";
+        moduleFileName << fileName << "/main.kiss";
         srcFile.open(moduleFileName.str());
         isDir = srcFile.good();
     }
     if(!isFile && !isDir) {
-        std::cout << "Not a valid filename: " << args[1] << std::endl;
-        moduleName = "";
-        code = "";
+        std::cout << "Not a valid filename: " << fileName << std::endl;
         return -1;
     }
     
@@ -74,11 +120,72 @@ const int Io::sourceCodeFromArgs(
     );
     
     if(isFile) {
-        moduleName = replace(std::string(args[1]), ".kiss", "");
+        moduleName = replace(std::string(fileName), ".kiss", "");
     } else {
-        moduleName = std::string(args[1]);
+        moduleName = std::string(fileName);
     }
     code = src;
     
     return 0;
 }
+
+const int Io::readSourceFile(const std::string &fileName, std::string &code) {
+    std::ifstream srcFile(fileName);
+    if(!srcFile.good() || !isRegularFile(fileName)) {
+        code = "";
+        return -1;
+    }
+    code.assign(
+        std::istreambuf_iterator<char>(srcFile),
+        std::istreambuf_iterator<char>()
+    );
+    return 0;
+}
+
+// The file sourceCodeFromArgs read the module from
+const std::string Io::moduleFileName(const std::string &moduleName) {
+    if(isRegularFile(moduleName + ".kiss")) {
+        return moduleName + ".kiss";
+    } else if(isDirectory(moduleName)) {
+        return moduleName + "/main.kiss";
+    }
+    return moduleName;
+}
+
+// A module that is a directory can't also be the name of the executable
+const std::string Io::outputFileName(const std::string &moduleName) {
+    if(isDirectory(moduleName)) {
+        return moduleName + "/main";
+    }
+    return moduleName;
+}
+
+/*
+ * Only the func lines of a profile written by an --instrument build matter
+ * here. Fields are tab separated since the file name may contain spaces,
+ * e.g. "func<TAB>beer<TAB>/src/ninetynine.kiss<TAB>5:6<TAB>count=98<TAB>..."
+ */
+const int Io::readProfile(
+        const std::string &fileName,
+        std::map<std::pair<std::string, std::string>, long long>
+            &callCounts) {
+    std::ifstream profileFile(fileName);
+    if(!profileFile.good()) {
+        return -1;
+    }
+    
+    std::string line;
+    while(std::getline(profileFile, line)) {
+        std::stringstream fields(line);
+        std::string kind, name, file, position, count;
+        std::getline(fields, kind, '\t');
+        std::getline(fields, name, '\t');
+        std::getline(fields, file, '\t');
+        std::getline(fields, position, '\t');
+        std::getline(fields, count, '\t');
+        if(kind == "func" && startsWith(count, "count=")) {
+            callCounts[{ file, name }] += std::atoll(count.substr(6).c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <filesystem>
+#include <Error.hpp>
+#include <Io.hpp>
+#include <Token.hpp>
+#include <Parser.hpp>
+#include <AstHelpers.hpp>
+#include <Modules.hpp>
+
+using namespace kisslang;
+
+// Either dir/name.kiss or dir/name/main.kiss, same as the module given to smooch
+inline const std::string importedFileName(
+        const std::string &moduleDir, const std::string &name,
+        std::string &code) {
+    const auto dir = std::filesystem::path(moduleDir);
+    const auto fileName = (dir / (name + ".kiss")).lexically_normal().string();
+    if(Io::readSourceFile(fileName, code) == 0) {
+        return fileName;
+    }
+    const auto mainFileName =
+        (dir / name / "main.kiss").lexically_normal().string();
+    if(Io::readSourceFile(mainFileName, code) == 0) {
+        return mainFileName;
+    }
+    return "";
+}
+
+// Imports are looked up next to the file that asks for them
+inline const std::string directoryOf(const std::string &fileName) {
+    const auto dir = std::filesystem::path(fileName).parent_path().string();
+    return dir == "" ? "." : dir;
+}
+
+// Positions alone would read as if an error was in the importing file
+static const CompoundToken parseImport(
+        const std::string &code, const std::string &fileName) {
+    try {
+        return Parser::parseAst(Parser::lexTokens(code));
+    } catch(const SmoochException &se) {
+        throw SmoochException(se, fileName);
+    }
+}
+
+static void linkInto(
+        std::vector<std::shared_ptr<Token>> &dest,
+        const std::vector<std::shared_ptr<Token>> &stmts,
+        const std::string &fileName, const bool &isMain,
+        std::set<std::string> &imported, Modules::SourceMap &sources) {
+    const auto moduleDir = directoryOf(fileName);
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        if(isImport(stmts, i)) {
+            const auto nameToken = stringLiteral(stmts[i]);
+            const auto name = nameToken->value.substr(
+                1, nameToken->value.length() - 2
+            );
+            
+            std::string code;
+            const auto importFileName = importedFileName(moduleDir, name, code);
+            if(importFileName == "") {
+                throw ImportException(*nameToken, name);
+            }
+            const auto key = Modules::canonicalFileName(importFileName);
+            if(imported.insert(key).second) {
+                const auto ast = parseImport(code, importFileName);
+                linkInto(
+                    dest, ast.children, importFileName, false, imported,
+                    sources
+                );
+            }
+            i++;
+            continue;
+        }
+        
+        const auto defLength = definitionLength(stmts, i);
+        if(defLength > 0) {
+            sources.definitionFiles[definedName(stmts, i).get()] = fileName;
+        }
+        if(isMain || defLength > 0) {
+            const auto length = defLength > 0 ? defLength : 1;
+            dest.insert(
+                dest.end(), stmts.begin() + i, stmts.begin() + i + length
+            );
+            i += length - 1;
+        }
+    }
+}
+
+// So ./lib.kiss and lib.kiss count as the same module
+const std::string Modules::canonicalFileName(const std::string &fileName) {
+    return std::filesystem::weakly_canonical(fileName).string();
+}
+
+const std::string &Modules::SourceMap::fileOf(
+        const std::shared_ptr<SymbolToken> &name) const {
+    const auto found = definitionFiles.find(name.get());
+    return found == definitionFiles.end() ? mainFileName : found->second;
+}
+
+// The main module counts as imported so a library can't pull it in again
+const CompoundToken Modules::link(
+        const CompoundToken &ast, const std::string &mainFileName,
+        SourceMap &sources) {
+    std::vector<std::shared_ptr<Token>> stmts;
+    std::set<std::string> imported = {
+        Modules::canonicalFileName(mainFileName)
+    };
+    sources.mainFileName = mainFileName;
+    linkInto(stmts, ast.children, mainFileName, true, imported, sources);
+    return CompoundToken(CompoundTokenType::Program, stmts);
+}
@@ -0,0 +1,1099 @@
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <Error.hpp>
+#include <Token.hpp>
+#include <NativeHelpers.hpp>
+#include <Modules.hpp>
+#include <Native.hpp>
+
+using namespace kisslang;
+
+/*
+ * Register use in generated code:
+ *  - r15 points at the next free slot of the data stack (8 bytes a slot)
+ *  - r14 points at the argument slot of the function currently running
+ * Everything else is scratch and may be clobbered by the runtime
+ */
+class NativeGenerator {
+    private:
+        struct FuncSig {
+            KissType input, output;
+        };
+
+        // One set of counters per instrumented func or loop
+        struct Probe {
+            std::string kind, name, file;
+            std::pair<int, int> position;
+        };
+
+        std::stringstream _mainText, _funcText, _printText, _rodata;
+        std::stringstream *_out;
+        std::map<std::string, FuncSig> _funcs;
+        std::map<std::string, std::string> _strLabels;
+        std::map<std::string, std::string> _printLabels;
+        std::vector<KissType> _types;
+        bool _dead;
+        bool _inFunc;
+        FuncSig _currFunc;
+        std::string _currFuncName;
+        int _labelCount;
+        int _reclaimingLoops;
+        const Modules::SourceMap &_sources;
+        std::string _currFileName;
+        const std::string _profileFileName;
+        std::vector<Probe> _probes;
+        std::size_t _funcProbe;
+        // The func and loops currently being generated, outermost first
+        std::vector<std::size_t> _openProbes;
+
+        void _emit(const std::string &line) {
+            *_out << "    " << line << "\n";
+        }
+
+        void _label(const std::string &label) {
+            *_out << label << ":\n";
+        }
+
+        const std::string _newLabel() {
+            return ".Lkiss" + std::to_string(_labelCount++);
+        }
+
+        const std::size_t _addProbe(
+                const std::string &kind, const SymbolToken &at) {
+            _probes.push_back({
+                kind, _currFuncName, _currFileName, at.position
+            });
+            return _probes.size() - 1;
+        }
+
+        /*
+         * Each probe is four qwords in kiss_prof:
+         * count, cycles, deepest data stack (in values) and bytes allocated.
+         * Cycles and bytes include whatever the func or loop calls
+         */
+        const std::string _probeField(
+                const std::size_t &probe, const int &field) {
+            return "QWORD PTR [rip + kiss_prof + "
+                + std::to_string(probe * 32 + field * 8) + "]";
+        }
+
+        void _pushTimestamp() {
+            _emit("rdtsc");
+            _emit("shl rdx, 32");
+            _emit("or rax, rdx");
+            _emit("push rax");
+        }
+
+        /*
+         * Raises the depth of every open probe to the data stack's current
+         * one. Done whenever the stack grows, so it only clobbers rcx
+         */
+        void _recordDepth() {
+            if(!_instrument() || _openProbes.empty()) {
+                return;
+            }
+            _emit("lea rcx, [rip + kiss_dstack]");
+            _emit("neg rcx");
+            _emit("add rcx, r15");
+            _emit("shr rcx, 3");
+            for(const auto &probe : _openProbes) {
+                const auto skip = _newLabel();
+                _emit("cmp rcx, " + _probeField(probe, 2));
+                _emit("jbe " + skip);
+                _emit("mov " + _probeField(probe, 2) + ", rcx");
+                _label(skip);
+            }
+        }
+
+        /*
+         * Everything ever allocated, counting what loops handed back, so
+         * probes still see the bytes a reclaiming loop went through
+         */
+        void _pushHeapUsed() {
+            _emit("mov rax, QWORD PTR [rip + kiss_heap_ptr]");
+            _emit("add rax, QWORD PTR [rip + kiss_heap_reclaimed]");
+            _emit("push rax");
+        }
+
+        // Pops what _pushTimestamp and _pushHeapUsed left behind
+        void _accumulateProbe(const std::size_t &probe) {
+            _emit("pop rcx");
+            _emit("mov rax, QWORD PTR [rip + kiss_heap_ptr]");
+            _emit("add rax, QWORD PTR [rip + kiss_heap_reclaimed]");
+            _emit("sub rax, rcx");
+            _emit("add " + _probeField(probe, 3) + ", rax");
+            _emit("rdtsc");
+            _emit("shl rdx, 32");
+            _emit("or rax, rdx");
+            _emit("pop rcx");
+            _emit("sub rax, rcx");
+            _emit("add " + _probeField(probe, 1) + ", rax");
+        }
+
+        void _pushRax() {
+            _emit("mov QWORD PTR [r15], rax");
+            _emit("add r15, 8");
+            _recordDepth();
+        }
+
+        void _popRax() {
+            _emit("sub r15, 8");
+            _emit("mov rax, QWORD PTR [r15]");
+        }
+
+        // Sign extend rax so it holds a value of the given byte width
+        void _normalize(const KissType &type) {
+            if(type.kind != KissKind::Int) {
+                return;
+            }
+            switch(type.size) {
+                case 1: _emit("movsx rax, al"); break;
+                case 2: _emit("movsx rax, ax"); break;
+                case 4: _emit("movsxd rax, eax"); break;
+                default: break;
+            }
+        }
+
+        const KissType _popType(const SymbolToken &at) {
+            if(_types.empty()) {
+                throw TypeException(at, "Stack underflow");
+            }
+            if(_types.back().kind == KissKind::Spread) {
+                throw UnsupportedException(
+                    at, "using unzipped items other than with zip"
+                );
+            }
+            const auto type = _types.back();
+            _types.pop_back();
+            return type;
+        }
+
+        const KissType _popType(const SymbolToken &at, const KissKind &kind) {
+            const auto type = _popType(at);
+            if(type.kind != kind) {
+                throw TypeException(at, "Unexpected " + type.str());
+            }
+            return type;
+        }
+
+        const KissType _popList(const SymbolToken &at) {
+            const auto type = _popType(at);
+            if(!isList(type)) {
+                throw TypeException(at, "Expected a list but got " + type.str());
+            }
+            return type;
+        }
+
+        const std::string _stringLabel(const std::string &value) {
+            const auto found = _strLabels.find(value);
+            if(found != _strLabels.end()) {
+                return found->second;
+            }
+
+            const auto label = "kiss_lit" + std::to_string(_strLabels.size());
+            _strLabels[value] = label;
+            _rodata << "    .balign 8\n" << label << ":\n";
+            _rodata << "    .quad " << value.length() << "\n";
+            for(const auto &chr : value) {
+                _rodata << "    .byte " << (static_cast<int>(chr) & 0xFF) << "\n";
+            }
+            return label;
+        }
+
+        // Items were pushed in order, so the first one is deepest
+        void _genList(const std::shared_ptr<CompoundToken> &list) {
+            const auto open = asSymbol(list->children[0]);
+            const auto count = list->children.size() - 2;
+            for(std::size_t i = 1; i <= count; i++) {
+                _genLiteral(asCompound(list->children[i]));
+            }
+            const auto item = _types.back();
+            for(std::size_t i = 0; i < count; i++) {
+                const auto type = _popType(*open);
+                if(type != item) {
+                    throw TypeException(
+                        *open, "List of " + item.str() + " holds " + type.str()
+                    );
+                }
+            }
+
+            const auto type = listOf(item);
+            const auto width = itemWidth(type);
+            _emit("mov edi, " + std::to_string(8 + count * width));
+            _emit("call kiss_alloc");
+            _emit("mov QWORD PTR [rax], " + std::to_string(count));
+            for(std::size_t i = 0; i < count; i++) {
+                _emit(
+                    "mov rcx, QWORD PTR [r15 - "
+                        + std::to_string((count - i) * 8) + "]"
+                );
+                if(width == 1) {
+                    _emit("mov BYTE PTR [rax + " + std::to_string(8 + i) + "], cl");
+                } else {
+                    _emit(
+                        "mov QWORD PTR [rax + " + std::to_string(8 + i * 8)
+                            + "], rcx"
+                    );
+                }
+            }
+            _emit("sub r15, " + std::to_string(count * 8));
+            _pushRax();
+            _types.push_back(type);
+        }
+
+        void _genTuple(const std::shared_ptr<CompoundToken> &tuple) {
+            _genLiteral(asCompound(tuple->children[1]));
+            _genLiteral(asCompound(tuple->children[2]));
+            const auto open = asSymbol(tuple->children[0]);
+            const auto second = _popType(*open);
+            const auto first = _popType(*open);
+
+            _emit("mov edi, 16");
+            _emit("call kiss_alloc");
+            _emit("mov rcx, QWORD PTR [r15 - 16]");
+            _emit("mov QWORD PTR [rax], rcx");
+            _emit("mov rcx, QWORD PTR [r15 - 8]");
+            _emit("mov QWORD PTR [rax + 8], rcx");
+            _emit("sub r15, 16");
+            _pushRax();
+            _types.push_back({ KissKind::Tuple, 8, { first, second } });
+        }
+
+        void _genLiteral(const std::shared_ptr<CompoundToken> &type) {
+            const auto raw = asCompound(type->children[0]);
+            if(raw->type == CompoundTokenType::List) {
+                _genList(raw);
+                return;
+            } else if(raw->type == CompoundTokenType::Tuple) {
+                _genTuple(raw);
+                return;
+            } else if(raw->type != CompoundTokenType::RawType) {
+                throw UnsupportedException(
+                    *firstSymbol(type), "struct literals"
+                );
+            }
+
+            const auto symbol = asSymbol(raw->children[0]);
+            switch(symbol->type) {
+                case SymbolTokenType::Integer: {
+                    int size = 0;
+                    const auto value = parseInteger(*symbol, size);
+                    _emit("mov rax, " + std::to_string(value));
+                    _pushRax();
+                    _types.push_back({ KissKind::Int, size });
+                } break;
+
+                case SymbolTokenType::Character: {
+                    const auto value = unescape(symbol->value.substr(2));
+                    _emit(
+                        "mov eax, "
+                            + std::to_string(static_cast<int>(value[0]) & 0xFF)
+                    );
+                    _pushRax();
+                    _types.push_back({ KissKind::Char, 1 });
+                } break;
+
+                case SymbolTokenType::Boolean:
+                    _emit(symbol->value == "true" ? "mov eax, 1" : "xor eax, eax");
+                    _pushRax();
+                    _types.push_back({ KissKind::Bool, 1 });
+                    break;
+
+                case SymbolTokenType::String: {
+                    const auto value = unescape(
+                        symbol->value.substr(1, symbol->value.length() - 2)
+                    );
+                    _emit("lea rax, [rip + " + _stringLabel(value) + "]");
+                    _pushRax();
+                    _types.push_back({ KissKind::Str, 8 });
+                } break;
+
+                default:
+                    throw UnsupportedException(*symbol, "float literals");
+            }
+        }
+
+        void _genCast(const std::shared_ptr<CompoundToken> &cast) {
+            const auto arrow = asSymbol(cast->children[0]);
+            const auto from = _popType(*arrow);
+            const auto to = typeFromTypeName(asCompound(cast->children[1]));
+
+            const auto compound = [](const KissType &type) {
+                return type.kind == KissKind::List || type.kind == KissKind::Tuple;
+            };
+            if(from != to && (compound(from) || compound(to))) {
+                throw TypeException(
+                    *arrow, "Cannot cast " + from.str() + " to " + to.str()
+                );
+            }
+
+            _emit("mov rax, QWORD PTR [r15 - 8]");
+            if(from == to && from.kind != KissKind::Int) {
+            } else if(from.kind == KissKind::Str && to.kind == KissKind::Int) {
+                _emit("mov rdi, rax");
+                _emit("call kiss_atoi");
+                _normalize(to);
+            } else if(from.kind == KissKind::Int && to.kind == KissKind::Str) {
+                _emit("mov rdi, rax");
+                _emit("call kiss_itoa");
+            } else if(from.kind == KissKind::Char && to.kind == KissKind::Str) {
+                _emit("mov rdi, rax");
+                _emit("call kiss_chrstr");
+            } else if(to.kind == KissKind::Int && from.kind != KissKind::Str) {
+                _normalize(to);
+            } else if(to.kind == KissKind::Char && from.kind == KissKind::Int) {
+                _emit("movzx eax, al");
+            } else if(to.kind == KissKind::Bool && from.kind == KissKind::Int) {
+                _emit("test rax, rax");
+                _emit("setne al");
+                _emit("movzx eax, al");
+            } else {
+                throw TypeException(
+                    *arrow, "Cannot cast " + from.str() + " to " + to.str()
+                );
+            }
+            _emit("mov QWORD PTR [r15 - 8], rax");
+            _types.push_back(to);
+        }
+
+        void _genUnaryOp(const SymbolToken &op) {
+            const auto type = _popType(op);
+            _emit("mov rax, QWORD PTR [r15 - 8]");
+            if(op.value == "!" && type.kind == KissKind::Bool) {
+                _emit("xor rax, 1");
+            } else if(op.value == "~" && type.kind == KissKind::Int) {
+                _emit("not rax");
+                _normalize(type);
+            } else if(op.value == "++" && type.kind == KissKind::Int) {
+                _emit("inc rax");
+                _normalize(type);
+            } else if(op.value == "--" && type.kind == KissKind::Int) {
+                _emit("dec rax");
+                _normalize(type);
+            } else {
+                throw TypeException(op, "Unexpected " + type.str());
+            }
+            _emit("mov QWORD PTR [r15 - 8], rax");
+            _types.push_back(type);
+        }
+
+        void _genBinaryOp(const SymbolToken &op) {
+            static const std::map<std::string, std::string> intOps = {
+                { "+", "add rax, rcx" },    { "-", "sub rax, rcx" },
+                { "*", "imul rax, rcx" },   { "&", "and rax, rcx" },
+                { "^", "xor rax, rcx" }
+            };
+            static const std::map<std::string, std::string> compareOps = {
+                { "==", "sete" },   { "!=", "setne" },
+                { "<", "setl" },    { ">", "setg" },
+                { "<=", "setle" },  { ">=", "setge" }
+            };
+
+            const auto right = _popType(op);
+            const auto left = _popType(op);
+            if(left != right) {
+                throw TypeException(
+                    op, "Mismatched " + left.str() + " and " + right.str()
+                );
+            }
+
+            _emit("mov rcx, QWORD PTR [r15 - 8]");
+            _emit("sub r15, 8");
+            _emit("mov rax, QWORD PTR [r15 - 8]");
+            auto result = left;
+            if(left.kind == KissKind::Str) {
+                _emit("mov rdi, rax");
+                _emit("mov rsi, rcx");
+                if(op.value == "+" || op.value == "++") {
+                    _emit("call kiss_concat");
+                } else if(op.value == "==" || op.value == "!=") {
+                    _emit("call kiss_streq");
+                    if(op.value == "!=") {
+                        _emit("xor eax, 1");
+                    }
+                    result = { KissKind::Bool, 1 };
+                } else {
+                    throw TypeException(op, "Unexpected [@]");
+                }
+            } else if(left.kind == KissKind::List
+                    && (op.value == "+" || op.value == "++")) {
+                _emit("mov rdi, rax");
+                _emit("mov rsi, rcx");
+                _emit("mov edx, 8");
+                _emit("call kiss_concat_wide");
+            } else if(left.kind == KissKind::List
+                    || left.kind == KissKind::Tuple) {
+                throw TypeException(op, "Unexpected " + left.str());
+            } else if(compareOps.count(op.value) > 0) {
+                _emit("cmp rax, rcx");
+                _emit(compareOps.at(op.value) + " al");
+                _emit("movzx eax, al");
+                result = { KissKind::Bool, 1 };
+            } else if(left.kind == KissKind::Bool
+                    && (op.value == "&&" || op.value == "||")) {
+                _emit(op.value == "&&" ? "and rax, rcx" : "or rax, rcx");
+            } else if(left.kind == KissKind::Int && intOps.count(op.value) > 0) {
+                _emit(intOps.at(op.value));
+                _normalize(left);
+            } else if(left.kind == KissKind::Int
+                    && (op.value == "/" || op.value == "%")) {
+                // idiv traps on 0 and on the one quotient that overflows,
+                // the smallest long over -1, which wraps like the rest
+                const auto divide = _newLabel();
+                const auto done = _newLabel();
+                _emit("test rcx, rcx");
+                _emit("jz kiss_div_zero");
+                _emit("cmp rcx, -1");
+                _emit("jne " + divide);
+                _emit(op.value == "/" ? "neg rax" : "xor eax, eax");
+                _emit("jmp " + done);
+                _label(divide);
+                _emit("cqo");
+                _emit("idiv rcx");
+                if(op.value == "%") {
+                    _emit("mov rax, rdx");
+                }
+                _label(done);
+                _normalize(left);
+            } else {
+                throw TypeException(op, "Unexpected " + left.str());
+            }
+            _emit("mov QWORD PTR [r15 - 8], rax");
+            _types.push_back(result);
+        }
+
+        /*
+         * `list index remove` and `index list --` both push the list without
+         * the item at index
+         */
+        void _genRemove(const SymbolToken &at, const bool &listOnTop) {
+            KissType list;
+            if(listOnTop) {
+                list = _popList(at);
+                _popType(at, KissKind::Int);
+                _emit("mov rdi, QWORD PTR [r15 - 8]");
+                _emit("mov rsi, QWORD PTR [r15 - 16]");
+            } else {
+                _popType(at, KissKind::Int);
+                list = _popList(at);
+                _emit("mov rsi, QWORD PTR [r15 - 8]");
+                _emit("mov rdi, QWORD PTR [r15 - 16]");
+            }
+            _emit("sub r15, 8");
+            _emit("mov edx, " + std::to_string(itemWidth(list)));
+            _emit("call kiss_remove");
+            _emit("mov QWORD PTR [r15 - 8], rax");
+            _types.push_back(list);
+        }
+
+        /*
+         * ++ increments a number but concatenates two lists, and -- decrements
+         * a number but removes an item from a list
+         */
+        void _genOperator(const SymbolToken &op) {
+            const auto listOnTop = !_types.empty() && isList(_types.back());
+            if(op.value == "=") {
+                throw UnsupportedException(op, "constants");
+            } else if(op.value == "--" && listOnTop) {
+                _genRemove(op, true);
+            } else if(op.value == "!" || op.value == "~" || op.value == "--"
+                    || (op.value == "++" && !listOnTop)) {
+                _genUnaryOp(op);
+            } else {
+                _genBinaryOp(op);
+            }
+        }
+
+        void _genReturn(const SymbolToken &ident) {
+            if(!_inFunc) {
+                throw TypeException(ident, "Return outside of a function");
+            }
+            const auto type = _popType(ident);
+            if(type != _currFunc.output) {
+                throw TypeException(
+                    ident, "Expected to return " + _currFunc.output.str()
+                        + " but got " + type.str()
+                );
+            }
+            _emit("mov rax, QWORD PTR [r15 - 8]");
+            _emit("mov r15, r14");
+            _pushRax();
+            if(_instrument()) {
+                // Loops may have left timestamps behind, r13 knows where we began
+                _emit("mov rsp, r13");
+                _emit("pop r13");
+                _accumulateProbe(_funcProbe);
+            }
+            _emit("pop r14");
+            _emit("ret");
+            _dead = true;
+        }
+
+        void _genIdentifier(const SymbolToken &ident) {
+            const auto &name = ident.value;
+            if(_funcs.count(name) > 0) {
+                const auto sig = _funcs.at(name);
+                const auto arg = _popType(ident);
+                if(arg != sig.input) {
+                    throw TypeException(
+                        ident, "Expected " + sig.input.str()
+                            + " but got " + arg.str()
+                    );
+                }
+                _emit("call kiss_fn_" + name);
+                _types.push_back(sig.output);
+            } else if(name == "return") {
+                _genReturn(ident);
+            } else if(name == "print") {
+                const auto type = _popType(ident);
+                _popRax();
+                _emit("mov rdi, rax");
+                _emit("call " + _printRoutine(type));
+            } else if(name == "dup") {
+                const auto type = _popType(ident);
+                _emit("mov rax, QWORD PTR [r15 - 8]");
+                _pushRax();
+                _types.push_back(type);
+                _types.push_back(type);
+            } else if(name == "pop") {
+                _popType(ident);
+                _emit("sub r15, 8");
+            } else if(name == "swap") {
+                const auto top = _popType(ident);
+                const auto below = _popType(ident);
+                _emit("mov rax, QWORD PTR [r15 - 8]");
+                _emit("mov rcx, QWORD PTR [r15 - 16]");
+                _emit("mov QWORD PTR [r15 - 8], rcx");
+                _emit("mov QWORD PTR [r15 - 16], rax");
+                _types.push_back(top);
+                _types.push_back(below);
+            } else if(name == "rot") {
+                // a b c -> c a b, the way ninetynine.kiss uses it
+                const auto third = _popType(ident);
+                const auto second = _popType(ident);
+                const auto first = _popType(ident);
+                _emit("mov rax, QWORD PTR [r15 - 8]");
+                _emit("mov rcx, QWORD PTR [r15 - 16]");
+                _emit("mov QWORD PTR [r15 - 8], rcx");
+                _emit("mov rcx, QWORD PTR [r15 - 24]");
+                _emit("mov QWORD PTR [r15 - 16], rcx");
+                _emit("mov QWORD PTR [r15 - 24], rax");
+                _types.push_back(third);
+                _types.push_back(first);
+                _types.push_back(second);
+            } else if(name == "at") {
+                _popType(ident, KissKind::Int);
+                const auto list = _popList(ident);
+                _emit("mov rcx, QWORD PTR [r15 - 8]");
+                _emit("sub r15, 8");
+                _emit("mov rax, QWORD PTR [r15 - 8]");
+                _emit("cmp rcx, QWORD PTR [rax]");
+                _emit("jae kiss_out_of_bounds");
+                if(itemWidth(list) == 1) {
+                    _emit("movzx eax, BYTE PTR [rax + rcx + 8]");
+                } else {
+                    _emit("mov rax, QWORD PTR [rax + rcx * 8 + 8]");
+                }
+                _emit("mov QWORD PTR [r15 - 8], rax");
+                _types.push_back(itemOf(list));
+            } else if(name == "remove") {
+                _genRemove(ident, false);
+            } else if(name == "unzip") {
+                const auto list = _popList(ident);
+                _popRax();
+                _emit("mov rsi, rax");
+                _emit("mov rdi, r15");
+                _emit("mov edx, " + std::to_string(itemWidth(list)));
+                _emit("call kiss_unzip");
+                _emit("mov r15, rax");
+                _recordDepth();
+                _types.push_back({ KissKind::Spread, 8, { itemOf(list) } });
+            } else if(name == "zip") {
+                _genZip(ident);
+            } else if(name == "input") {
+                _emit("call kiss_input");
+                _pushRax();
+                _types.push_back({ KissKind::Str, 8 });
+            } else if(name == "write") {
+                _popType(ident, KissKind::Str);
+                _popType(ident, KissKind::Str);
+                _emit("mov rsi, QWORD PTR [r15 - 8]");
+                _emit("mov rdi, QWORD PTR [r15 - 16]");
+                _emit("sub r15, 16");
+                _emit("call kiss_write_file");
+            } else if(name == "read") {
+                _popType(ident, KissKind::Str);
+                _emit("mov rdi, QWORD PTR [r15 - 8]");
+                _emit("call kiss_read_file");
+                _emit("mov QWORD PTR [r15 - 8], rax");
+                _types.push_back({ KissKind::Str, 8 });
+            } else {
+                throw UnsupportedException(ident, "identifier '" + name + "'");
+            }
+        }
+
+        /*
+         * Takes every item of the top item's type off the stack, including
+         * whole runs left by unzip, and pushes them back as one list.
+         * rbx counts the items and r12 walks down to the bottom of the run
+         */
+        void _genZip(const SymbolToken &ident) {
+            if(_types.empty()) {
+                throw TypeException(ident, "Stack underflow");
+            }
+            const auto item = _types.back().kind == KissKind::Spread ?
+                _types.back().inner[0] : _types.back();
+            std::vector<KissType> run;
+            while(!_types.empty() && (_types.back() == item
+                    || (_types.back().kind == KissKind::Spread
+                        && _types.back().inner[0] == item))) {
+                run.push_back(_types.back());
+                _types.pop_back();
+            }
+
+            const auto list = listOf(item);
+            const auto width = itemWidth(list);
+            _emit("xor ebx, ebx");
+            _emit("mov r12, r15");
+            for(const auto &entry : run) {
+                if(entry.kind == KissKind::Spread) {
+                    _emit("mov rax, QWORD PTR [r12 - 8]");
+                    _emit("add rbx, rax");
+                    _emit("shl rax, 3");
+                    _emit("sub r12, rax");
+                    _emit("sub r12, 8");
+                } else {
+                    _emit("inc rbx");
+                    _emit("sub r12, 8");
+                }
+            }
+            _emit("mov rdi, rbx");
+            _emit("imul rdi, rdi, " + std::to_string(width));
+            _emit("add rdi, 8");
+            _emit("call kiss_alloc");
+            _emit("mov QWORD PTR [rax], rbx");
+
+            // Fill from the last item down so each run keeps its order
+            _emit("lea rdi, [rax + 8]");
+            _emit("imul rcx, rbx, " + std::to_string(width));
+            _emit("add rdi, rcx");
+            _emit("mov rsi, r15");
+            const auto store = width == 1 ?
+                "mov BYTE PTR [rdi], dl" : "mov QWORD PTR [rdi], rdx";
+            for(const auto &entry : run) {
+                if(entry.kind == KissKind::Spread) {
+                    const auto next = _newLabel();
+                    const auto done = _newLabel();
+                    _emit("sub rsi, 8");
+                    _emit("mov rcx, QWORD PTR [rsi]");
+                    _label(next);
+                    _emit("test rcx, rcx");
+                    _emit("jz " + done);
+                    _emit("sub rsi, 8");
+                    _emit("sub rdi, " + std::to_string(width));
+                    _emit("mov rdx, QWORD PTR [rsi]");
+                    _emit(store);
+                    _emit("dec rcx");
+                    _emit("jmp " + next);
+                    _label(done);
+                } else {
+                    _emit("sub rsi, 8");
+                    _emit("sub rdi, " + std::to_string(width));
+                    _emit("mov rdx, QWORD PTR [rsi]");
+                    _emit(store);
+                }
+            }
+            _emit("mov r15, r12");
+            _pushRax();
+            _types.push_back(list);
+        }
+
+        /*
+         * Label of a routine that prints a value of the given type from rdi.
+         * Lists and tuples get one generated the first time they're printed
+         */
+        const std::string _printRoutine(const KissType &type) {
+            switch(type.kind) {
+                case KissKind::Int: return "kiss_print_int";
+                case KissKind::Char: return "kiss_print_char";
+                case KissKind::Bool: return "kiss_print_bool";
+                case KissKind::Str: return "kiss_print_str";
+                default: break;
+            }
+            const auto found = _printLabels.find(type.str());
+            if(found != _printLabels.end()) {
+                return found->second;
+            }
+
+            std::vector<std::string> itemRoutines;
+            for(const auto &inner : type.inner) {
+                itemRoutines.push_back(_printRoutine(inner));
+            }
+            const auto label = "kiss_print_" + std::to_string(_printLabels.size());
+            _printLabels[type.str()] = label;
+            const auto open = _stringLabel(type.kind == KissKind::List ? "[" : "(");
+            const auto close = _stringLabel(type.kind == KissKind::List ? "]" : ")");
+            const auto space = _stringLabel(" ");
+
+            const auto outer = _out;
+            _out = &_printText;
+            _label(label);
+            _emit("push r12");
+            _emit("push rbx");
+            _emit("mov r12, rdi");
+            _emit("lea rdi, [rip + " + open + "]");
+            _emit("call kiss_print_str");
+            if(type.kind == KissKind::Tuple) {
+                _emit("mov rdi, QWORD PTR [r12]");
+                _emit("call " + itemRoutines[0]);
+                _emit("lea rdi, [rip + " + space + "]");
+                _emit("call kiss_print_str");
+                _emit("mov rdi, QWORD PTR [r12 + 8]");
+                _emit("call " + itemRoutines[1]);
+            } else {
+                const auto next = _newLabel();
+                const auto noSpace = _newLabel();
+                const auto done = _newLabel();
+                _emit("xor ebx, ebx");
+                _label(next);
+                _emit("cmp rbx, QWORD PTR [r12]");
+                _emit("jae " + done);
+                _emit("test rbx, rbx");
+                _emit("jz " + noSpace);
+                _emit("lea rdi, [rip + " + space + "]");
+                _emit("call kiss_print_str");
+                _label(noSpace);
+                _emit("mov rdi, QWORD PTR [r12 + rbx * 8 + 8]");
+                _emit("call " + itemRoutines[0]);
+                _emit("inc rbx");
+                _emit("jmp " + next);
+                _label(done);
+            }
+            _emit("lea rdi, [rip + " + close + "]");
+            _emit("call kiss_print_str");
+            _emit("pop rbx");
+            _emit("pop r12");
+            _emit("ret");
+            _out = outer;
+            return label;
+        }
+
+        void _genBody(const std::shared_ptr<CompoundToken> &body) {
+            // First and last children are the braces themselves
+            for(std::size_t i = 1; i < body->children.size() - 1; i++) {
+                _genStatement(body->children[i]);
+            }
+        }
+
+        static const bool _onHeap(const KissType &type) {
+            return type.kind == KissKind::Str || type.kind == KissKind::List
+                || type.kind == KissKind::Tuple
+                || type.kind == KissKind::Spread;
+        }
+
+        /*
+         * A loop pops a condition and runs its body while it is true.
+         * The body has to leave the stack as it found it, plus a new condition.
+         *
+         * The data stack is the only thing that can hold on to heap values,
+         * so when nothing on it (below this func's frame is older anyway) can
+         * point into the heap, whatever an iteration allocated is garbage by
+         * its end and the heap pointer goes back to where the iteration began
+         */
+        void _genLoop(const std::shared_ptr<CompoundToken> &loop) {
+            const auto keyword = asSymbol(loop->children[0]);
+            _popType(*keyword, KissKind::Bool);
+            const auto before = _types;
+            const auto top = _newLabel();
+            const auto end = _newLabel();
+            const auto probe = _instrument() ? _addProbe("loop", *keyword) : 0;
+            bool reclaim = true;
+            for(const auto &type : before) {
+                reclaim = reclaim && !_onHeap(type);
+            }
+            const auto heapSlot = "QWORD PTR [rip + kiss_loop_heap + "
+                + std::to_string(_reclaimingLoops * 8) + "]";
+            if(reclaim) {
+                _reclaimingLoops++;
+            }
+
+            if(_instrument()) {
+                _pushTimestamp();
+                _pushHeapUsed();
+            }
+            _popRax();
+            _emit("test rax, rax");
+            _emit("jz " + end);
+            _label(top);
+            if(reclaim) {
+                _emit("mov rcx, QWORD PTR [rip + kiss_heap_ptr]");
+                _emit("mov " + heapSlot + ", rcx");
+            }
+            if(_instrument()) {
+                _openProbes.push_back(probe);
+                _emit("inc " + _probeField(probe, 0));
+                _recordDepth();
+            }
+            _genBody(asCompound(loop->children[1]));
+            if(_instrument()) {
+                _openProbes.pop_back();
+            }
+            if(!_dead) {
+                auto expected = before;
+                expected.push_back({ KissKind::Bool, 1 });
+                if(_types != expected) {
+                    throw TypeException(
+                        *keyword,
+                        "Loop body must keep the stack and push a condition"
+                    );
+                }
+                if(reclaim) {
+                    _emit("mov rcx, " + heapSlot);
+                    _emit("mov rdx, QWORD PTR [rip + kiss_heap_ptr]");
+                    _emit("sub rdx, rcx");
+                    _emit("add QWORD PTR [rip + kiss_heap_reclaimed], rdx");
+                    _emit("mov QWORD PTR [rip + kiss_heap_ptr], rcx");
+                }
+                _popRax();
+                _emit("test rax, rax");
+                _emit("jnz " + top);
+            }
+            _label(end);
+            if(_instrument()) {
+                _accumulateProbe(probe);
+            }
+
+            _types = before;
+            _dead = false;
+        }
+
+        void _genFuncDef(const std::shared_ptr<CompoundToken> &funcDef) {
+            const auto name = asSymbol(funcDef->children[1]);
+            const auto outerTypes = _types;
+            const auto outerProbes = _openProbes;
+            _out = &_funcText;
+            _currFunc = _funcs.at(name->value);
+            _types = { _currFunc.input };
+            _currFuncName = name->value;
+            _currFileName = Modules::canonicalFileName(_sources.fileOf(name));
+            _inFunc = true;
+            _dead = false;
+
+            _label("kiss_fn_" + name->value);
+            _emit("push r14");
+            _emit("lea r14, [r15 - 8]");
+            if(_instrument()) {
+                _funcProbe = _addProbe("func", *name);
+                _emit("inc " + _probeField(_funcProbe, 0));
+                _pushTimestamp();
+                _pushHeapUsed();
+                _emit("push r13");
+                _emit("mov r13, rsp");
+                _openProbes = { _funcProbe };
+                _recordDepth();
+            }
+            _genBody(asCompound(funcDef->children[6]));
+            if(!_dead) {
+                if(_types.size() != 1 || _types[0] != _currFunc.output) {
+                    throw TypeException(
+                        *name, "Function must end by returning "
+                            + _currFunc.output.str()
+                    );
+                }
+                _genReturn(*name);
+            }
+
+            _out = &_mainText;
+            _types = outerTypes;
+            _openProbes = outerProbes;
+            _currFuncName = "main";
+            _currFileName = Modules::canonicalFileName(_sources.mainFileName);
+            _inFunc = false;
+            _dead = false;
+        }
+
+        void _genStatement(const std::shared_ptr<Token> &stmt) {
+            if(_dead) {
+                throw TypeException(*firstSymbol(stmt), "Unreachable statement");
+            }
+
+            if(stmt->isSymbol()) {
+                const auto symbol = asSymbol(stmt);
+                if(symbol->type == SymbolTokenType::Operator) {
+                    _genOperator(*symbol);
+                } else {
+                    _genIdentifier(*symbol);
+                }
+                return;
+            }
+
+            const auto compound = asCompound(stmt);
+            switch(compound->type) {
+                case CompoundTokenType::Type:
+                    _genLiteral(compound);
+                    break;
+                case CompoundTokenType::Cast:
+                    _genCast(compound);
+                    break;
+                case CompoundTokenType::Loop:
+                    _genLoop(compound);
+                    break;
+                case CompoundTokenType::FuncDef:
+                    // generate() handles the top-level ones itself
+                    throw UnsupportedException(
+                        *firstSymbol(stmt), "nested functions"
+                    );
+                default:
+                    throw UnsupportedException(
+                        *firstSymbol(stmt), "struct definitions"
+                    );
+            }
+        }
+
+        // Signatures come first so functions can call each other in any order
+        void _collectFuncs(const CompoundToken &ast) {
+            for(const auto &stmt : ast.children) {
+                if(stmt->isSymbol()
+                        || asCompound(stmt)->type != CompoundTokenType::FuncDef) {
+                    continue;
+                }
+                const auto funcDef = asCompound(stmt);
+                const auto name = asSymbol(funcDef->children[1]);
+                if(_funcs.count(name->value) > 0) {
+                    throw TypeException(*name, "Function already defined");
+                }
+                _funcs[name->value] = {
+                    typeFromTypeName(asCompound(funcDef->children[3])),
+                    typeFromTypeName(asCompound(funcDef->children[5]))
+                };
+            }
+        }
+
+        const bool _instrument() const {
+            return _profileFileName != "";
+        }
+
+        /*
+         * Written out by kiss_exit and kiss_fail as tab separated lines of
+         * "<kind> <func> <file> <line>:<col> count=..." so a file name can
+         * have spaces in it. Without --instrument there's nothing to write
+         */
+        void _genProfileWriter() {
+            _out = &_funcText;
+            _label("kiss_write_profile");
+            if(!_instrument()) {
+                _emit("ret");
+                _out = &_mainText;
+                return;
+            }
+            _emit("push r12");
+            _emit("lea r12, [rip + kiss_str_empty]");
+            for(std::size_t i = 0; i < _probes.size(); i++) {
+                const auto &probe = _probes[i];
+                const std::vector<std::string> labels = {
+                    probe.kind + "\t" + probe.name + "\t" + probe.file + "\t"
+                        + std::to_string(probe.position.first) + ":"
+                        + std::to_string(probe.position.second) + "\tcount=",
+                    "\tcycles=", "\tdepth=", "\talloc="
+                };
+                for(int field = 0; field < 4; field++) {
+                    _emit("mov rdi, r12");
+                    _emit(
+                        "lea rsi, [rip + " + _stringLabel(labels[field]) + "]"
+                    );
+                    _emit("mov rdx, " + _probeField(i, field));
+                    _emit("call kiss_prof_append");
+                    _emit("mov r12, rax");
+                }
+                _emit("mov rdi, r12");
+                _emit("lea rsi, [rip + " + _stringLabel("\n") + "]");
+                _emit("call kiss_concat");
+                _emit("mov r12, rax");
+            }
+            _emit("lea rdi, [rip + " + _stringLabel(_profileFileName) + "]");
+            _emit("mov rsi, r12");
+            _emit("call kiss_write_file");
+            _emit("pop r12");
+            _emit("ret");
+            _out = &_mainText;
+        }
+
+    public:
+        NativeGenerator(
+                const Modules::SourceMap &sources,
+                const std::string &profileFileName) :
+                _out(&_mainText), _dead(false), _inFunc(false),
+                _currFuncName("main"), _labelCount(0), _reclaimingLoops(0),
+                _sources(sources),
+                _currFileName(Modules::canonicalFileName(sources.mainFileName)),
+                _profileFileName(profileFileName), _funcProbe(0) {
+        }
+
+        const std::string generate(const CompoundToken &ast) {
+            _collectFuncs(ast);
+            for(const auto &stmt : ast.children) {
+                if(isCompoundOf(stmt, CompoundTokenType::FuncDef)) {
+                    _genFuncDef(asCompound(stmt));
+                } else {
+                    _genStatement(stmt);
+                }
+            }
+            _genProfileWriter();
+
+            std::stringstream asmCode;
+            asmCode << "    .intel_syntax noprefix\n";
+            asmCode << "    .text\n";
+            asmCode << "    .globl _start\n";
+            asmCode << "_start:\n";
+            asmCode << "    lea r15, [rip + kiss_dstack]\n";
+            asmCode << _mainText.str();
+            asmCode << "    jmp kiss_exit\n\n";
+            asmCode << _funcText.str();
+            asmCode << _printText.str();
+            asmCode << Native::runtimeAssembly();
+            asmCode << "\n    .section .rodata\n";
+            asmCode << _rodata.str();
+            asmCode << "\n    .bss\n    .balign 8\nkiss_loop_heap:\n";
+            asmCode << "    .skip " << (_reclaimingLoops * 8 + 8) << "\n";
+            if(_instrument()) {
+                asmCode << "kiss_prof:\n";
+                asmCode << "    .skip " << (_probes.size() * 32 + 8) << "\n";
+            }
+            return asmCode.str();
+        }
+};
+
+const std::string Native::generateAssembly(
+        const CompoundToken &ast, const Modules::SourceMap &sources,
+        const std::string &profileFileName) {
+    NativeGenerator generator(sources, profileFileName);
+    return generator.generate(ast);
+}
+
+const int Native::assemble(
+        const std::string &outputFileName, const std::string &asmCode) {
+    const auto asmFileName = outputFileName + ".s";
+    const auto objFileName = outputFileName + ".o";
+    std::ofstream asmFile(asmFileName);
+    asmFile << asmCode;
+    asmFile.close();
+
+    const auto command =
+        "as --64 -o '" + objFileName + "' '" + asmFileName + "' && "
+        + "ld -static -o '" + outputFileName + "' '" + objFileName + "'";
+    const auto result = std::system(command.c_str());
+    std::remove(asmFileName.c_str());
+    std::remove(objFileName.c_str());
+    if(result != 0) {
+        std::cout << "Failed to assemble " << outputFileName << "." << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,512 @@
+#include <string>
+#include <Native.hpp>
+
+using namespace kisslang;
+
+/*
+ * The runtime every natively compiled module is linked with.
+ * It only talks to the kernel through syscalls so no libc is needed.
+ *
+ * Strings are a pointer to { qword length; bytes... } living in a bump heap.
+ * The heap is only given back by loops, see NativeGenerator::_genLoop.
+ * The generated code supplies kiss_write_profile, which kiss_exit and
+ * kiss_fail call last; kiss_fail first empties the heap, since nothing in it
+ * is needed any more and the profile may have to be written after an OOM.
+ * Other lists store a qword per item instead of a byte, and tuples are a
+ * pointer to their two qwords.
+ * Routines take arguments in rdi/rsi/rdx (rdx is the item width for list
+ * routines), return in rax, keep rbx/r12/r13 and never touch the data stack
+ * registers r14/r15.
+ */
+static const std::string runtimeText = R"(
+kiss_alloc:
+    mov rax, QWORD PTR [rip + kiss_heap_ptr]
+    add rdi, 7
+    and rdi, -8
+    lea rdx, [rax + rdi]
+    lea rcx, [rip + kiss_heap_end]
+    cmp rdx, rcx
+    ja kiss_oom
+    mov QWORD PTR [rip + kiss_heap_ptr], rdx
+    ret
+
+kiss_oom:
+    lea rdi, [rip + kiss_str_oom]
+    jmp kiss_fail
+
+kiss_out_of_bounds:
+    lea rdi, [rip + kiss_str_bounds]
+    jmp kiss_fail
+
+kiss_stack_overflow:
+    lea rdi, [rip + kiss_str_overflow]
+    jmp kiss_fail
+
+kiss_div_zero:
+    lea rdi, [rip + kiss_str_div_zero]
+
+kiss_fail:
+    push rdi
+    call kiss_flush
+    lea rax, [rip + kiss_heap]
+    mov QWORD PTR [rip + kiss_heap_ptr], rax
+    call kiss_write_profile
+    pop rdi
+    lea rsi, [rdi + 8]
+    mov rdx, QWORD PTR [rdi]
+    mov edi, 2
+    mov eax, 1
+    syscall
+    mov edi, 1
+    mov eax, 60
+    syscall
+
+kiss_flush:
+    mov rdx, QWORD PTR [rip + kiss_out_len]
+    test rdx, rdx
+    jz .Lflush_done
+    lea rsi, [rip + kiss_out_buf]
+    mov edi, 1
+    mov eax, 1
+    syscall
+    mov QWORD PTR [rip + kiss_out_len], 0
+.Lflush_done:
+    ret
+
+kiss_write_out:
+    mov rax, QWORD PTR [rip + kiss_out_len]
+    lea rcx, [rax + rdx]
+    cmp rcx, 4096
+    jbe .Lwrite_copy
+    push rsi
+    push rdx
+    call kiss_flush
+    pop rdx
+    pop rsi
+    cmp rdx, 4096
+    jb .Lwrite_empty
+    mov edi, 1
+    mov eax, 1
+    syscall
+    ret
+.Lwrite_empty:
+    xor eax, eax
+.Lwrite_copy:
+    lea rdi, [rip + kiss_out_buf]
+    add rdi, rax
+    add rax, rdx
+    mov QWORD PTR [rip + kiss_out_len], rax
+    mov rcx, rdx
+    rep movsb
+    ret
+
+kiss_print_str:
+    lea rsi, [rdi + 8]
+    mov rdx, QWORD PTR [rdi]
+    jmp kiss_write_out
+
+kiss_print_char:
+    sub rsp, 8
+    mov BYTE PTR [rsp], dil
+    mov rsi, rsp
+    mov edx, 1
+    call kiss_write_out
+    add rsp, 8
+    ret
+
+kiss_print_bool:
+    test rdi, rdi
+    lea rdi, [rip + kiss_str_true]
+    lea rax, [rip + kiss_str_false]
+    cmovz rdi, rax
+    jmp kiss_print_str
+
+kiss_fmt_int:
+    mov rax, rdi
+    mov r8, rdi
+    test rax, rax
+    jns .Lfmt_positive
+    neg rax
+.Lfmt_positive:
+    mov ecx, 10
+.Lfmt_digit:
+    xor edx, edx
+    div rcx
+    add dl, 48
+    dec rsi
+    mov BYTE PTR [rsi], dl
+    test rax, rax
+    jnz .Lfmt_digit
+    test r8, r8
+    jns .Lfmt_done
+    dec rsi
+    mov BYTE PTR [rsi], 45
+.Lfmt_done:
+    mov rax, rsi
+    ret
+
+kiss_print_int:
+    sub rsp, 24
+    lea rsi, [rsp + 24]
+    call kiss_fmt_int
+    mov rsi, rax
+    lea rdx, [rsp + 24]
+    sub rdx, rax
+    call kiss_write_out
+    add rsp, 24
+    ret
+
+kiss_itoa:
+    push r12
+    push r13
+    sub rsp, 24
+    lea rsi, [rsp + 24]
+    call kiss_fmt_int
+    mov r12, rax
+    lea r13, [rsp + 24]
+    sub r13, rax
+    lea rdi, [r13 + 8]
+    call kiss_alloc
+    mov QWORD PTR [rax], r13
+    lea rdi, [rax + 8]
+    mov rsi, r12
+    mov rcx, r13
+    rep movsb
+    add rsp, 24
+    pop r13
+    pop r12
+    ret
+
+kiss_atoi:
+    mov rcx, QWORD PTR [rdi]
+    lea rsi, [rdi + 8]
+    xor eax, eax
+    xor r8d, r8d
+    test rcx, rcx
+    jz .Latoi_done
+    cmp BYTE PTR [rsi], 45
+    jne .Latoi_digit
+    mov r8d, 1
+    inc rsi
+    dec rcx
+.Latoi_digit:
+    test rcx, rcx
+    jz .Latoi_sign
+    movzx edx, BYTE PTR [rsi]
+    sub edx, 48
+    cmp edx, 9
+    ja .Latoi_sign
+    imul rax, rax, 10
+    add rax, rdx
+    inc rsi
+    dec rcx
+    jmp .Latoi_digit
+.Latoi_sign:
+    test r8, r8
+    jz .Latoi_done
+    neg rax
+.Latoi_done:
+    ret
+
+kiss_chrstr:
+    push r12
+    mov r12, rdi
+    mov edi, 9
+    call kiss_alloc
+    mov QWORD PTR [rax], 1
+    mov BYTE PTR [rax + 8], r12b
+    pop r12
+    ret
+
+kiss_concat:
+    mov edx, 1
+kiss_concat_wide:
+    push r12
+    push r13
+    push rbx
+    push rdx
+    mov r12, rdi
+    mov r13, rsi
+    mov rbx, QWORD PTR [rdi]
+    add rbx, QWORD PTR [rsi]
+    mov rdi, rbx
+    imul rdi, rdx
+    add rdi, 8
+    call kiss_alloc
+    pop rdx
+    mov QWORD PTR [rax], rbx
+    lea rdi, [rax + 8]
+    lea rsi, [r12 + 8]
+    mov rcx, QWORD PTR [r12]
+    imul rcx, rdx
+    rep movsb
+    lea rsi, [r13 + 8]
+    mov rcx, QWORD PTR [r13]
+    imul rcx, rdx
+    rep movsb
+    pop rbx
+    pop r13
+    pop r12
+    ret
+
+kiss_remove:
+    cmp rsi, QWORD PTR [rdi]
+    jae kiss_out_of_bounds
+    push r12
+    push r13
+    push rbx
+    mov r12, rdi
+    mov r13, rsi
+    mov rbx, rdx
+    mov rdi, QWORD PTR [r12]
+    dec rdi
+    imul rdi, rbx
+    add rdi, 8
+    call kiss_alloc
+    mov rcx, QWORD PTR [r12]
+    dec rcx
+    mov QWORD PTR [rax], rcx
+    lea rdi, [rax + 8]
+    lea rsi, [r12 + 8]
+    mov rcx, r13
+    imul rcx, rbx
+    rep movsb
+    add rsi, rbx
+    mov rcx, QWORD PTR [r12]
+    sub rcx, r13
+    dec rcx
+    imul rcx, rbx
+    rep movsb
+    pop rbx
+    pop r13
+    pop r12
+    ret
+
+kiss_unzip:
+    mov rcx, QWORD PTR [rsi]
+    lea rax, [rdi + rcx * 8 + 8]
+    lea r8, [rip + kiss_dstack_end]
+    cmp rax, r8
+    ja kiss_stack_overflow
+    lea r8, [rsi + 8]
+    xor r9d, r9d
+.Lunzip_item:
+    cmp r9, rcx
+    jae .Lunzip_done
+    cmp rdx, 1
+    jne .Lunzip_qword
+    movzx eax, BYTE PTR [r8 + r9]
+    jmp .Lunzip_store
+.Lunzip_qword:
+    mov rax, QWORD PTR [r8 + r9 * 8]
+.Lunzip_store:
+    mov QWORD PTR [rdi], rax
+    add rdi, 8
+    inc r9
+    jmp .Lunzip_item
+.Lunzip_done:
+    mov QWORD PTR [rdi], rcx
+    lea rax, [rdi + 8]
+    ret
+
+kiss_streq:
+    mov rcx, QWORD PTR [rdi]
+    cmp rcx, QWORD PTR [rsi]
+    jne .Lstreq_differ
+    add rdi, 8
+    add rsi, 8
+    repe cmpsb
+    jne .Lstreq_differ
+    mov eax, 1
+    ret
+.Lstreq_differ:
+    xor eax, eax
+    ret
+
+kiss_cstr:
+    push r12
+    mov r12, rdi
+    mov rdi, QWORD PTR [r12]
+    inc rdi
+    call kiss_alloc
+    mov rdi, rax
+    lea rsi, [r12 + 8]
+    mov rcx, QWORD PTR [r12]
+    rep movsb
+    mov BYTE PTR [rdi], 0
+    pop r12
+    ret
+
+kiss_input:
+    push r12
+    push r13
+    call kiss_flush
+    mov r12, QWORD PTR [rip + kiss_heap_ptr]
+    xor r13d, r13d
+.Linput_byte:
+    lea rsi, [r12 + r13 + 8]
+    lea rcx, [rip + kiss_heap_end]
+    cmp rsi, rcx
+    jae kiss_oom
+    xor edi, edi
+    mov edx, 1
+    xor eax, eax
+    syscall
+    cmp rax, 1
+    jne .Linput_done
+    cmp BYTE PTR [r12 + r13 + 8], 10
+    je .Linput_done
+    inc r13
+    jmp .Linput_byte
+.Linput_done:
+    mov QWORD PTR [r12], r13
+    lea rdi, [r13 + 8]
+    call kiss_alloc
+    pop r13
+    pop r12
+    ret
+
+kiss_write_file:
+    push r12
+    push r13
+    mov r13, rsi
+    call kiss_cstr
+    mov rdi, rax
+    mov esi, 577
+    mov edx, 420
+    mov eax, 2
+    syscall
+    mov r12, rax
+    test rax, rax
+    js .Lwrite_file_done
+    mov rdi, r12
+    lea rsi, [r13 + 8]
+    mov rdx, QWORD PTR [r13]
+    mov eax, 1
+    syscall
+    mov rdi, r12
+    mov eax, 3
+    syscall
+.Lwrite_file_done:
+    pop r13
+    pop r12
+    ret
+
+kiss_read_file:
+    push r12
+    push r13
+    call kiss_cstr
+    mov rdi, rax
+    xor esi, esi
+    mov eax, 2
+    syscall
+    mov r12, rax
+    test rax, rax
+    js .Lread_file_fail
+    mov rdi, r12
+    xor esi, esi
+    mov edx, 2
+    mov eax, 8
+    syscall
+    mov r13, rax
+    mov rdi, r12
+    xor esi, esi
+    xor edx, edx
+    mov eax, 8
+    syscall
+    lea rdi, [r13 + 8]
+    call kiss_alloc
+    mov QWORD PTR [rax], r13
+    push rax
+    mov rdi, r12
+    lea rsi, [rax + 8]
+    mov rdx, r13
+    xor eax, eax
+    syscall
+    mov rdi, r12
+    mov eax, 3
+    syscall
+    pop rax
+    jmp .Lread_file_done
+.Lread_file_fail:
+    lea rax, [rip + kiss_str_empty]
+.Lread_file_done:
+    pop r13
+    pop r12
+    ret
+
+kiss_prof_append:
+    push r12
+    push r13
+    mov r12, rdx
+    call kiss_concat
+    mov r13, rax
+    mov rdi, r12
+    call kiss_itoa
+    mov rdi, r13
+    mov rsi, rax
+    call kiss_concat
+    pop r13
+    pop r12
+    ret
+
+kiss_exit:
+    call kiss_flush
+    call kiss_write_profile
+    xor edi, edi
+    mov eax, 60
+    syscall
+
+    .data
+    .balign 8
+kiss_heap_ptr:
+    .quad kiss_heap
+kiss_out_len:
+    .quad 0
+kiss_heap_reclaimed:
+    .quad 0
+
+    .section .rodata
+    .balign 8
+kiss_str_true:
+    .quad 4
+    .ascii "true"
+    .balign 8
+kiss_str_false:
+    .quad 5
+    .ascii "false"
+    .balign 8
+kiss_str_empty:
+    .quad 0
+    .balign 8
+kiss_str_oom:
+    .quad 14
+    .ascii "Out of memory\n"
+    .balign 8
+kiss_str_bounds:
+    .quad 20
+    .ascii "Index out of bounds\n"
+    .balign 8
+kiss_str_overflow:
+    .quad 15
+    .ascii "Stack overflow\n"
+    .balign 8
+kiss_str_div_zero:
+    .quad 17
+    .ascii "Division by zero\n"
+
+    .bss
+    .balign 16
+kiss_out_buf:
+    .skip 4096
+kiss_dstack:
+    .skip 8388608
+kiss_dstack_end:
+kiss_heap:
+    .skip 268435456
+kiss_heap_end:
+)";
+
+const std::string Native::runtimeAssembly() {
+    return runtimeText;
+}
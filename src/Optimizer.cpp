@@ -0,0 +1,673 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <utility>
+#include <Error.hpp>
+#include <Token.hpp>
+#include <AstHelpers.hpp>
+#include <Modules.hpp>
+#include <Optimizer.hpp>
+
+using namespace kisslang;
+
+// e.g. lib.kiss, line 4, col 6
+inline const std::string sourcePosition(
+        const std::string &fileName, const SymbolToken &token) {
+    return fileName + ", line " + std::to_string(token.position.first)
+        + ", col " + std::to_string(token.position.second);
+}
+
+inline const std::string definitionKind(
+        const std::vector<std::shared_ptr<Token>> &stmts,
+        const std::size_t &index) {
+    if(isCompoundOf(stmts[index], CompoundTokenType::FuncDef)) {
+        return "func";
+    } else if(stmts[index]->isSymbol()) {
+        return "struct";
+    }
+    return "constant";
+}
+
+// Everything a definition refers to, leaving out the name it defines
+inline void collectDefinitionRefs(
+        const std::vector<std::shared_ptr<Token>> &stmts,
+        const std::size_t &index, std::set<std::string> &names) {
+    if(isCompoundOf(stmts[index], CompoundTokenType::FuncDef)) {
+        const auto &children = asCompound(stmts[index])->children;
+        for(std::size_t i = 2; i < children.size(); i++) {
+            collectIdentifiers(children[i], names);
+        }
+    } else if(stmts[index]->isSymbol()) {
+        collectIdentifiers(stmts[index + 1], names);
+    } else {
+        collectIdentifiers(stmts[index], names);
+    }
+}
+
+/*
+ * Reachability starts at the top-level statements that aren't definitions.
+ * A definition is kept only if something reachable names it
+ */
+const CompoundToken Optimizer::eliminateDeadCode(
+        const CompoundToken &program, const Modules::SourceMap &sources,
+        std::vector<std::string> &report) {
+    const auto &stmts = program.children;
+    
+    std::map<std::string, std::size_t> definitions;
+    std::set<std::string> pending;
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        const auto length = definitionLength(stmts, i);
+        if(length > 0) {
+            definitions[definedName(stmts, i)->value] = i;
+            i += length - 1;
+        } else {
+            collectIdentifiers(stmts[i], pending);
+        }
+    }
+    
+    std::set<std::string> live;
+    while(!pending.empty()) {
+        const auto name = *pending.begin();
+        pending.erase(pending.begin());
+        const auto found = definitions.find(name);
+        if(found == definitions.end() || !live.insert(name).second) {
+            continue;
+        }
+        std::set<std::string> refs;
+        collectDefinitionRefs(stmts, found->second, refs);
+        for(const auto &ref : refs) {
+            if(live.count(ref) == 0) {
+                pending.insert(ref);
+            }
+        }
+    }
+    
+    std::vector<std::shared_ptr<Token>> kept;
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        const auto length = definitionLength(stmts, i);
+        if(length == 0) {
+            kept.push_back(stmts[i]);
+            continue;
+        }
+        
+        const auto name = definedName(stmts, i);
+        if(live.count(name->value) > 0) {
+            kept.insert(kept.end(), stmts.begin() + i, stmts.begin() + i + length);
+        } else {
+            report.push_back(
+                "Removed unused " + definitionKind(stmts, i) + " '"
+                    + name->value + "' ("
+                    + sourcePosition(sources.fileOf(name), *name) + ")"
+            );
+        }
+        i += length - 1;
+    }
+    return CompoundToken(CompoundTokenType::Program, kept);
+}
+
+inline const bool isIntTypeName(const std::string &type) {
+    return type.rfind("#:", 0) == 0;
+}
+
+inline const bool isListTypeName(const std::string &type) {
+    return type.rfind("[", 0) == 0;
+}
+
+/*
+ * Applies a straight-line statement to the types on the stack, each one
+ * written like a type name (#:1, [@], ...), the way the backends check them.
+ * Returns false for anything it can't follow, type errors included, so the
+ * types are only trusted while every statement so far was understood
+ */
+static const bool applyTypes(
+        const std::shared_ptr<Token> &stmt,
+        const std::map<std::string, std::shared_ptr<CompoundToken>> &funcs,
+        std::vector<std::string> &types) {
+    static const std::set<std::string> compareOps = {
+        "==", "!=", "<", ">", "<=", ">="
+    };
+    static const std::set<std::string> intOps = {
+        "+", "-", "*", "/", "%", "&", "^"
+    };
+    const auto pop = [&types](std::string &type) {
+        if(types.empty()) {
+            return false;
+        }
+        type = types.back();
+        types.pop_back();
+        return true;
+    };
+    
+    std::string top, below, third;
+    if(isCompoundOf(stmt, CompoundTokenType::Type)) {
+        const auto type = literalTypeName(stmt);
+        if(type == "") {
+            return false;
+        }
+        types.push_back(type);
+        return true;
+    } else if(isCompoundOf(stmt, CompoundTokenType::Cast)) {
+        if(!pop(top)) {
+            return false;
+        }
+        types.push_back(typeNameStr(asCompound(stmt)->children[1]));
+        return true;
+    } else if(isCompoundOf(stmt, CompoundTokenType::FuncDef)) {
+        return true;
+    } else if(!stmt->isSymbol()) {
+        return false;
+    }
+    
+    const auto &name = asSymbol(stmt)->value;
+    if(asSymbol(stmt)->type == SymbolTokenType::Operator) {
+        // ++ and -- work on a number, or on a list and what's below it
+        const auto listOnTop = !types.empty() && isListTypeName(types.back());
+        const auto unary = name == "!" || name == "~"
+            || ((name == "++" || name == "--") && !listOnTop);
+        if(name == "--" && listOnTop) {
+            if(!pop(top) || !pop(below) || !isIntTypeName(below)) {
+                return false;
+            }
+            types.push_back(top);
+            return true;
+        } else if(unary) {
+            if(!pop(top) || (name == "!" ? top != "?" : !isIntTypeName(top))) {
+                return false;
+            }
+            types.push_back(top);
+            return true;
+        } else if(!pop(top) || !pop(below) || top != below) {
+            return false;
+        } else if(compareOps.count(name) > 0) {
+            if(top != "?" && top != "@" && !isIntTypeName(top)
+                    && top != "[@]") {
+                return false;
+            }
+            types.push_back("?");
+        } else if((name == "&&" || name == "||") && top == "?") {
+            types.push_back(top);
+        } else if(isIntTypeName(top) && intOps.count(name) > 0) {
+            types.push_back(top);
+        } else if(isListTypeName(top) && (name == "+" || name == "++")) {
+            types.push_back(top);
+        } else {
+            return false;
+        }
+        return true;
+    } else if(funcs.count(name) > 0) {
+        const auto funcDef = funcs.at(name);
+        if(!pop(top) || top != typeNameStr(funcDef->children[3])) {
+            return false;
+        }
+        types.push_back(typeNameStr(funcDef->children[5]));
+        return true;
+    }
+    
+    if(name == "print" || name == "pop") {
+        return pop(top);
+    } else if(name == "dup") {
+        if(!pop(top)) {
+            return false;
+        }
+        types.insert(types.end(), { top, top });
+    } else if(name == "swap") {
+        if(!pop(top) || !pop(below)) {
+            return false;
+        }
+        types.insert(types.end(), { top, below });
+    } else if(name == "rot") {
+        if(!pop(top) || !pop(below) || !pop(third)) {
+            return false;
+        }
+        types.insert(types.end(), { top, third, below });
+    } else if(name == "input") {
+        types.push_back("[@]");
+    } else if(name == "write") {
+        return pop(top) && pop(below) && top == "[@]" && below == "[@]";
+    } else if(name == "read") {
+        if(!pop(top) || top != "[@]") {
+            return false;
+        }
+        types.push_back(top);
+    } else if(name == "at" || name == "remove") {
+        if(!pop(top) || !pop(below) || !isIntTypeName(top)
+                || !isListTypeName(below)) {
+            return false;
+        }
+        types.push_back(
+            name == "at" ? below.substr(1, below.length() - 2) : below
+        );
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Folds literal-only expressions at the end of a statement list, so
+ * 99:1 <<[@]>> ' bottles' + becomes '99 bottles'. Returns whether it did
+ */
+static const bool foldTail(std::vector<std::shared_ptr<Token>> &stmts) {
+    bool changed = false;
+    while(true) {
+        const auto size = stmts.size();
+        if(size >= 2 && rawLiteral(stmts[size - 2])
+                && isSymbolOf(
+                    stmts.back(), SymbolTokenType::Identifier, "dup"
+                )) {
+            stmts.back() = stmts[size - 2];
+            changed = true;
+            continue;
+        }
+        
+        if(size >= 2 && isCompoundOf(stmts[size - 1], CompoundTokenType::Cast)
+                && rawLiteral(stmts[size - 2])) {
+            const auto lit = rawLiteral(stmts[size - 2]);
+            if(lit->type != SymbolTokenType::Integer) {
+                return changed;
+            }
+            int litSize = 0;
+            const auto value = parseInteger(*lit, litSize);
+            const auto to = typeNameStr(asCompound(stmts.back())->children[1]);
+            
+            std::shared_ptr<Token> folded;
+            if(to == "[@]") {
+                folded = makeLiteral(
+                    SymbolTokenType::String, "'" + std::to_string(value) + "'",
+                    lit->position
+                );
+            } else if(isIntTypeName(to)) {
+                const auto toSize = to[2] - '0';
+                folded = makeLiteral(
+                    SymbolTokenType::Integer,
+                    integerLiteral(wrapInteger(value, toSize), toSize),
+                    lit->position
+                );
+            } else {
+                return changed;
+            }
+            stmts.erase(stmts.end() - 2, stmts.end());
+            stmts.push_back(folded);
+            changed = true;
+            continue;
+        }
+        
+        if(size < 3 || !stmts.back()->isSymbol()
+                || asSymbol(stmts.back())->type != SymbolTokenType::Operator
+                || !rawLiteral(stmts[size - 2]) || !rawLiteral(stmts[size - 3])) {
+            return changed;
+        }
+        const auto op = asSymbol(stmts.back())->value;
+        const auto left = rawLiteral(stmts[size - 3]);
+        const auto right = rawLiteral(stmts[size - 2]);
+        if(left->type != right->type) {
+            return changed;
+        }
+        
+        std::shared_ptr<Token> folded;
+        if(left->type == SymbolTokenType::String
+                && (op == "+" || op == "++")) {
+            const auto leftStr = left->value.substr(0, left->value.length() - 1);
+            folded = makeLiteral(
+                SymbolTokenType::String, leftStr + right->value.substr(1),
+                left->position
+            );
+        } else if(left->type == SymbolTokenType::Integer) {
+            int leftSize = 0, rightSize = 0;
+            const auto a = parseInteger(*left, leftSize);
+            const auto b = parseInteger(*right, rightSize);
+            if(leftSize != rightSize) {
+                return changed;
+            }
+            
+            const auto ua = static_cast<unsigned long long>(a);
+            const auto ub = static_cast<unsigned long long>(b);
+            unsigned long long result = 0;
+            if(op == "+") {
+                result = ua + ub;
+            } else if(op == "-") {
+                result = ua - ub;
+            } else if(op == "*") {
+                result = ua * ub;
+            } else if(op == "&") {
+                result = ua & ub;
+            } else if(op == "^") {
+                result = ua ^ ub;
+            } else if(op == "==" || op == "!=" || op == "<" || op == ">") {
+                const auto truth = op == "==" ? a == b : op == "!=" ? a != b
+                    : op == "<" ? a < b : a > b;
+                folded = makeLiteral(
+                    SymbolTokenType::Boolean, truth ? "true" : "false",
+                    left->position
+                );
+            } else {
+                return changed;
+            }
+            if(!folded) {
+                folded = makeLiteral(
+                    SymbolTokenType::Integer,
+                    integerLiteral(wrapInteger(result, leftSize), leftSize),
+                    left->position
+                );
+            }
+        } else {
+            return changed;
+        }
+        stmts.erase(stmts.end() - 3, stmts.end());
+        stmts.push_back(folded);
+        changed = true;
+    }
+}
+
+/*
+ * Splices small non-recursive functions into their callers.
+ * A function qualifies when its body is straight-line code ending in its
+ * only return, never reaches below its own argument, declares no constants
+ * (those would leak into the caller's frame) and fits in the threshold.
+ * A literal argument doubles the budget since it usually folds away.
+ * Past that budget the call is left alone; funcs are never cloned to
+ * specialize them for a constant argument.
+ * A call is only replaced where the argument is known to have the func's
+ * input type, since inlining drops the check the call itself makes.
+ *
+ * With a profile from an --instrument run, funcs that were never called are
+ * left alone and ones called at least hotCallCount times get four times the
+ * budget. Funcs missing from the profile are treated as if there was none.
+ */
+static const long long hotCallCount = 1000;
+
+class Inliner {
+    private:
+        const int _threshold;
+        // Calls counted by an --instrument run, keyed by file and func
+        const std::map<std::pair<std::string, std::string>, long long>
+            &_callCounts;
+        const Modules::SourceMap &_sources;
+        std::vector<std::string> &_report;
+        std::map<std::string, std::shared_ptr<CompoundToken>> _funcs;
+        std::map<std::string, std::vector<std::shared_ptr<Token>>> _bodies;
+        std::set<std::string> _inProgress;
+        std::set<std::string> _recursive;
+        std::string _lastFold;
+        
+        static const std::vector<std::shared_ptr<Token>> _bodyStmts(
+                const std::shared_ptr<CompoundToken> &body) {
+            return std::vector<std::shared_ptr<Token>>(
+                body->children.begin() + 1, body->children.end() - 1
+            );
+        }
+        
+        static const std::shared_ptr<CompoundToken> _withBody(
+                const std::shared_ptr<CompoundToken> &body,
+                const std::vector<std::shared_ptr<Token>> &stmts) {
+            std::vector<std::shared_ptr<Token>> children;
+            children.push_back(body->children.front());
+            children.insert(children.end(), stmts.begin(), stmts.end());
+            children.push_back(body->children.back());
+            return std::make_shared<CompoundToken>(
+                CompoundTokenType::Body, children
+            );
+        }
+        
+        void _findRecursion() {
+            std::map<std::string, std::set<std::string>> callees;
+            for(const auto &[name, funcDef] : _funcs) {
+                std::set<std::string> refs;
+                collectIdentifiers(funcDef->children[6], refs);
+                for(const auto &ref : refs) {
+                    if(_funcs.count(ref) > 0) {
+                        callees[name].insert(ref);
+                    }
+                }
+            }
+            
+            for(const auto &[name, funcDef] : _funcs) {
+                std::set<std::string> seen;
+                std::vector<std::string> pending(
+                    callees[name].begin(), callees[name].end()
+                );
+                while(!pending.empty()) {
+                    const auto callee = pending.back();
+                    pending.pop_back();
+                    if(callee == name) {
+                        _recursive.insert(name);
+                        break;
+                    }
+                    if(seen.insert(callee).second) {
+                        pending.insert(
+                            pending.end(), callees[callee].begin(),
+                            callees[callee].end()
+                        );
+                    }
+                }
+            }
+        }
+        
+        static const std::string _inputType(
+                const std::shared_ptr<CompoundToken> &funcDef) {
+            return typeNameStr(funcDef->children[3]);
+        }
+        
+        static const std::string _outputType(
+                const std::shared_ptr<CompoundToken> &funcDef) {
+            return typeNameStr(funcDef->children[5]);
+        }
+        
+        // The body has to turn its input into its output and nothing else
+        const bool _isInlinable(
+                const std::string &name,
+                const std::vector<std::shared_ptr<Token>> &body) {
+            if(body.empty()
+                    || !isSymbolOf(
+                        body.back(), SymbolTokenType::Identifier, "return"
+                    )) {
+                return false;
+            }
+            
+            const auto funcDef = _funcs.at(name);
+            std::vector<std::string> types = { _inputType(funcDef) };
+            for(std::size_t i = 0; i < body.size() - 1; i++) {
+                if(!applyTypes(body[i], _funcs, types)) {
+                    return false;
+                }
+            }
+            return types == std::vector<std::string>({ _outputType(funcDef) });
+        }
+        
+        const std::vector<std::shared_ptr<Token>> &_optimizedBody(
+                const std::string &name) {
+            if(_bodies.count(name) == 0) {
+                const auto body = _bodyStmts(
+                    asCompound(_funcs.at(name)->children[6])
+                );
+                if(_inProgress.count(name) > 0) {
+                    return _bodies[name] = body;
+                }
+                _inProgress.insert(name);
+                const auto funcName = asSymbol(_funcs.at(name)->children[1]);
+                std::vector<std::string> types = {
+                    _inputType(_funcs.at(name))
+                };
+                const auto optimized = _inlineStmts(
+                    body, _sources.fileOf(funcName), types
+                );
+                _inProgress.erase(name);
+                _bodies[name] = optimized;
+            }
+            return _bodies.at(name);
+        }
+        
+        /*
+         * Folding is part of inlining, so a threshold of 0 turns both off.
+         * A chain folded one statement at a time is reported once, with
+         * what it ended up as
+         */
+        void _foldTail(
+                std::vector<std::shared_ptr<Token>> &stmts,
+                const std::string &fileName) {
+            if(_threshold <= 0 || !foldTail(stmts)) {
+                return;
+            }
+            const auto literal = rawLiteral(stmts.back());
+            const auto position = sourcePosition(fileName, *literal);
+            const auto line = "Folded constants at " + position + " into "
+                + literal->value;
+            if(!_report.empty() && _report.back() == _lastFold) {
+                const auto prefix = "Folded constants at " + position + " ";
+                if(_lastFold.rfind(prefix, 0) == 0) {
+                    _report.pop_back();
+                }
+            }
+            _report.push_back(line);
+            _lastFold = line;
+        }
+        
+        // How often the profile says name was called, -1 if it doesn't say
+        const long long _callCount(const std::string &name) const {
+            const auto funcName = asSymbol(_funcs.at(name)->children[1]);
+            const auto count = _callCounts.find({
+                Modules::canonicalFileName(_sources.fileOf(funcName)), name
+            });
+            return count == _callCounts.end() ? -1 : count->second;
+        }
+        
+        const bool _isHot(const std::string &name) const {
+            return _callCount(name) >= hotCallCount;
+        }
+        
+        const bool _shouldInline(
+                const std::string &name, const bool &literalArg) {
+            if(_threshold <= 0 || _recursive.count(name) > 0
+                    || _inProgress.count(name) > 0) {
+                return false;
+            }
+            auto budget = literalArg ? _threshold * 2 : _threshold;
+            if(_callCount(name) == 0) {
+                return false;
+            } else if(_isHot(name)) {
+                budget *= 4;
+            }
+            const auto &body = _optimizedBody(name);
+            return static_cast<int>(body.size()) - 1 <= budget
+                && _isInlinable(name, body);
+        }
+        
+        /*
+         * fileName is where stmts came from, for the report, and types is
+         * what's known to be on the stack when they start. Once a statement
+         * isn't understood nothing more is known until the end of stmts
+         */
+        const std::vector<std::shared_ptr<Token>> _inlineStmts(
+                const std::vector<std::shared_ptr<Token>> &stmts,
+                const std::string &fileName, std::vector<std::string> types) {
+            std::vector<std::shared_ptr<Token>> result;
+            bool known = true;
+            for(const auto &stmt : stmts) {
+                if(stmt->isSymbol() && _funcs.count(asSymbol(stmt)->value) > 0) {
+                    const auto call = asSymbol(stmt);
+                    const auto funcDef = _funcs.at(call->value);
+                    const bool literalArg = !result.empty()
+                        && rawLiteral(result.back()) != nullptr;
+                    if(known && !types.empty()
+                            && types.back() == _inputType(funcDef)
+                            && _shouldInline(call->value, literalArg)) {
+                        const auto &body = _optimizedBody(call->value);
+                        for(std::size_t i = 0; i < body.size() - 1; i++) {
+                            result.push_back(body[i]);
+                            _foldTail(result, fileName);
+                        }
+                        _report.push_back(
+                            "Inlined '" + call->value + "' at "
+                                + sourcePosition(fileName, *call)
+                                + (literalArg ? " (constant argument)" : "")
+                                + (_isHot(call->value) ? " (hot)" : "")
+                        );
+                        types.back() = _outputType(funcDef);
+                        continue;
+                    }
+                } else if(isCompoundOf(stmt, CompoundTokenType::Loop)) {
+                    // A loop pops its condition each time around
+                    const auto loop = asCompound(stmt);
+                    const auto body = asCompound(loop->children[1]);
+                    known = known && !types.empty() && types.back() == "?";
+                    if(known) {
+                        types.pop_back();
+                    }
+                    result.push_back(std::make_shared<CompoundToken>(
+                        CompoundTokenType::Loop,
+                        std::vector<std::shared_ptr<Token>>({
+                            loop->children[0],
+                            _withBody(
+                                body,
+                                _inlineStmts(
+                                    _bodyStmts(body), fileName,
+                                    known ? types : std::vector<std::string>()
+                                )
+                            )
+                        })
+                    ));
+                    continue;
+                }
+                result.push_back(stmt);
+                _foldTail(result, fileName);
+                known = known && applyTypes(stmt, _funcs, types);
+            }
+            return result;
+        }
+        
+    public:
+        Inliner(
+                const int &threshold,
+                const std::map<std::pair<std::string, std::string>, long long>
+                    &callCounts,
+                const Modules::SourceMap &sources,
+                std::vector<std::string> &report) :
+                _threshold(threshold), _callCounts(callCounts),
+                _sources(sources), _report(report) {
+        }
+        
+        const CompoundToken run(const CompoundToken &program) {
+            for(const auto &stmt : program.children) {
+                if(isCompoundOf(stmt, CompoundTokenType::FuncDef)) {
+                    const auto funcDef = asCompound(stmt);
+                    _funcs[asSymbol(funcDef->children[1])->value] = funcDef;
+                }
+            }
+            _findRecursion();
+            
+            std::vector<std::shared_ptr<Token>> stmts;
+            for(const auto &stmt : program.children) {
+                if(!isCompoundOf(stmt, CompoundTokenType::FuncDef)) {
+                    stmts.push_back(stmt);
+                    continue;
+                }
+                
+                // Rebuild the definition around its optimized body
+                const auto funcDef = asCompound(stmt);
+                auto children = funcDef->children;
+                children[6] = _withBody(
+                    asCompound(children[6]),
+                    _optimizedBody(asSymbol(children[1])->value)
+                );
+                stmts.push_back(std::make_shared<CompoundToken>(
+                    CompoundTokenType::FuncDef, children
+                ));
+            }
+            return CompoundToken(
+                CompoundTokenType::Program,
+                _inlineStmts(stmts, _sources.mainFileName, {})
+            );
+        }
+};
+
+const CompoundToken Optimizer::inlineCalls(
+        const CompoundToken &program, const int &threshold,
+        const std::map<std::pair<std::string, std::string>, long long>
+            &callCounts,
+        const Modules::SourceMap &sources,
+        std::vector<std::string> &report) {
+    Inliner inliner(threshold, callCounts, sources, report);
+    return inliner.run(program);
+}
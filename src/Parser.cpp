@@ -4,74 +4,138 @@
 #include <memory>
 #include <Error.hpp>
 #include <Token.hpp>
+#include <Pattern.hpp>
 #include <ParserHelpers.hpp>
 #include <Parser.hpp>
 
 using namespace kisslang;
 
+struct SymbolRule {
+    Pattern pattern;
+    SymbolTokenType type;
+};
+
+struct CompoundRule {
+    Pattern pattern;
+    CompoundTokenType type;
+};
+
 // Can't use map for these because it MUST be in the correct order
-static const std::vector<std::pair<std::string, SymbolTokenType>>
-        symbolRegexs = {
-    { "loop|func|struct",                   SymbolTokenType::Keyword },
-    { "true|false",                         SymbolTokenType::Boolean },
+static constexpr SymbolRule symbolPatterns[] = {
+    { compilePattern("loop|func|struct"),   SymbolTokenType::Keyword },
+    { compilePattern("true|false"),         SymbolTokenType::Boolean },
     {
-        "([0-9]+|0x[0-9A-Za-z]+|0b[01]+):[1248]",
+        compilePattern("([0-9]+|0x[0-9A-Za-z]+|0b[01]+):[1248]"),
         SymbolTokenType::Integer
     },
-    { "([0-9]+\\.[0-9]*|\\.[0-9]+):[48]",   SymbolTokenType::Float },
-    { "0c(\\\\.|[^\\\\])",                  SymbolTokenType::Character },
-    { "'(\\\\.|[^\\\\'])*'",                SymbolTokenType::String },
-    { "#:[1248]|\\.:[48]|@|\\?",            SymbolTokenType::TypeChar },
-    { "[A-Za-z_][A-Za-z_0-9]*",             SymbolTokenType::Identifier },
-    { "\\(|\\)",                            SymbolTokenType::Parenth },
-    { "\\[|\\]",                            SymbolTokenType::Bracket },
-    { "\\{|\\}",                            SymbolTokenType::Brace },
-    { "->",                                 SymbolTokenType::ReturnOp },
-    { "<<|>>",                              SymbolTokenType::DoubleArrow },
     {
-        "\\+|-|\\*|\\/|%|\\+\\+|--|==|!=|>|<|>=|<=|&&|\\|\\||!|&|\\^|~|=",
+        compilePattern("([0-9]+\\.[0-9]*|\\.[0-9]+):[48]"),
+        SymbolTokenType::Float
+    },
+    { compilePattern("0c(\\\\.|[^\\\\])"), SymbolTokenType::Character },
+    { compilePattern("'(\\\\.|[^\\\\'])*'"), SymbolTokenType::String },
+    { compilePattern("#:[1248]|\\.:[48]|@|\\?"), SymbolTokenType::TypeChar },
+    {
+        compilePattern("[A-Za-z_][A-Za-z_0-9]*"),
+        SymbolTokenType::Identifier
+    },
+    { compilePattern("\\(|\\)"),            SymbolTokenType::Parenth },
+    { compilePattern("\\[|\\]"),            SymbolTokenType::Bracket },
+    { compilePattern("\\{|\\}"),            SymbolTokenType::Brace },
+    { compilePattern("->"),                 SymbolTokenType::ReturnOp },
+    { compilePattern("<<|>>"),              SymbolTokenType::DoubleArrow },
+    {
+        compilePattern(
+            "\\+\\+|--|==|!=|>=|<=|&&|\\|\\||\\+|-|\\*|\\/|%|>|<|!|&|\\^|~|="
+        ),
         SymbolTokenType::Operator
     },
-    { "\\$",                                SymbolTokenType::Dollar },
-    { "::",                                 SymbolTokenType::TypeOp },
-    { "\\.",                                SymbolTokenType::MemberOp }
+    { compilePattern("\\$"),                SymbolTokenType::Dollar },
+    { compilePattern("::"),                 SymbolTokenType::TypeOp },
+    { compilePattern("\\."),                SymbolTokenType::MemberOp }
 };
-static const std::vector<std::pair<std::string, CompoundTokenType>> 
-        compoundRegexs = {
-    { "[bic'f]",                        CompoundTokenType::RawType },
-    { "\\(tt\\(",                       CompoundTokenType::Tuple },
-    { "\\[t+\\[",                       CompoundTokenType::List },
-    { "\\(n\\(\\{t*\\{",                CompoundTokenType::Struct },
-    { "n(\\.n)+",                       CompoundTokenType::StructAccess },
-    { "@|\\$n|(\\(NN\\()|(\\[N\\[)",    CompoundTokenType::TypeName },
-    { "kn:N>N\\}",                      CompoundTokenType::FuncDef },
-    { "[r,lsS]" ,                       CompoundTokenType::Type },
-    { "\\{[tFLa=nd]*\\{",               CompoundTokenType::Body },
-    { "k\\}",                           CompoundTokenType::Loop },
-    { "<N<",                            CompoundTokenType::Cast },
-    { "k\\{(n:N)*\\{",                  CompoundTokenType::StructDef }
+static constexpr CompoundRule compoundPatterns[] = {
+    { compilePattern("[bic'f]"),            CompoundTokenType::RawType },
+    { compilePattern("\\(tt\\("),           CompoundTokenType::Tuple },
+    { compilePattern("\\[t+\\["),           CompoundTokenType::List },
+    { compilePattern("\\(n\\(\\{t*\\{"),    CompoundTokenType::Struct },
+    { compilePattern("n(\\.n)+"),           CompoundTokenType::StructAccess },
+    {
+        compilePattern("@|\\$n|(\\(NN\\()|(\\[N\\[)"),
+        CompoundTokenType::TypeName
+    },
+    { compilePattern("kn:N>N\\}"),          CompoundTokenType::FuncDef },
+    { compilePattern("[r,lsS]"),            CompoundTokenType::Type },
+    { compilePattern("\\{[tFLa=nd]*\\{"),   CompoundTokenType::Body },
+    { compilePattern("k\\}"),               CompoundTokenType::Loop },
+    { compilePattern("<N<"),                CompoundTokenType::Cast },
+    { compilePattern("k\\{(n:N)*\\{"),      CompoundTokenType::StructDef }
 };
 
+// How many characters of str the first symbol rule that matches takes
+static constexpr std::size_t lexedLength(
+        const char *const str, const SymbolTokenType type) {
+    auto end = str;
+    while(*end != '\0') {
+        end++;
+    }
+    for(const auto &rule : symbolPatterns) {
+        const auto found = matchPattern(rule.pattern, str, end);
+        if(found != nullptr) {
+            return rule.type == type ? found - str : 0;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Cases where taking a different alternative or a lazier repeat would still
+ * match something, just not what std::regex picks
+ */
+static_assert(lexedLength("++", SymbolTokenType::Operator) == 2);
+static_assert(lexedLength("+1", SymbolTokenType::Operator) == 1);
+static_assert(lexedLength("--", SymbolTokenType::Operator) == 2);
+static_assert(lexedLength("->", SymbolTokenType::ReturnOp) == 2);
+static_assert(lexedLength("<<", SymbolTokenType::DoubleArrow) == 2);
+static_assert(lexedLength("<=", SymbolTokenType::Operator) == 2);
+static_assert(lexedLength("||", SymbolTokenType::Operator) == 2);
+static_assert(lexedLength("'a\\'b' 'c'", SymbolTokenType::String) == 6);
+static_assert(lexedLength("'a\\\\' b'", SymbolTokenType::String) == 5);
+static_assert(lexedLength("''", SymbolTokenType::String) == 2);
+static_assert(lexedLength("0c\\'", SymbolTokenType::Character) == 4);
+static_assert(lexedLength("0x1F:4", SymbolTokenType::Integer) == 6);
+static_assert(lexedLength("10:8", SymbolTokenType::Integer) == 4);
+static_assert(lexedLength("1.5:8", SymbolTokenType::Float) == 5);
+static_assert(lexedLength(".:4", SymbolTokenType::TypeChar) == 3);
+static_assert(lexedLength("loopy", SymbolTokenType::Keyword) == 4);
+static_assert(lexedLength("trueish", SymbolTokenType::Boolean) == 4);
+static_assert(lexedLength("x_1.y", SymbolTokenType::Identifier) == 3);
+
 const std::vector<SymbolToken> Parser::lexTokens(const std::string &code) {
     std::vector<SymbolToken> tokens;
+    const char *const codeEnd = code.data() + code.length();
     int line = 1, col = 1;
     for(auto codeStrIt = code.begin(); codeStrIt != code.end(); ++codeStrIt) {
         if(shouldSkipSpaces(*codeStrIt, line, col)) {
             continue;
         }
         
-        bool foundMatches = false;
-        const auto currStr = std::string(codeStrIt, code.end());
-        for(const auto &[regexStr, type] : symbolRegexs) {
-            const auto matchStr = matchRegEx(regexStr, currStr, foundMatches);
-            if(foundMatches && startswith(currStr, matchStr)) {
-                tokens.push_back(SymbolToken(type, matchStr, { line, col }));
-                codeStrIt += matchStr.length() - 1;
-                col += matchStr.length() - 1;
+        bool foundMatch = false;
+        const char *const currPos = &*codeStrIt;
+        for(const auto &[pattern, type] : symbolPatterns) {
+            const auto matchEnd = matchPattern(pattern, currPos, codeEnd);
+            if(matchEnd != nullptr) {
+                const std::size_t matchLength = matchEnd - currPos;
+                tokens.push_back(SymbolToken(
+                    type, std::string(currPos, matchLength), { line, col }
+                ));
+                codeStrIt += matchLength - 1;
+                col += matchLength - 1;
+                foundMatch = true;
                 break;
             }
         }
-        if(!foundMatches) {
+        if(!foundMatch) {
             throw UnknownTokenException(line, col);
         }
         
@@ -85,15 +149,15 @@ const CompoundToken Parser::parseAst(const std::vector<SymbolToken> &tokens) {
     std::vector<std::shared_ptr<Token>> tokenTree;
     copySymbolTokensToParentPtrs(tokenTree, tokens);
     
+    // Kept in step with tokenTree by hand instead of being rebuilt each time
     auto currTreeStr = Token::tokenListAsTypeStr(tokenTree);
     while(nonStatementIndex(currTreeStr) != -1) {
-        const auto oldStr = currTreeStr;
+        bool changed = false;
         
-        std::string matchStr;
-        for(const auto &[regexStr, tokenType] : compoundRegexs) {      
-            while(matchRegex(regexStr, currTreeStr, matchStr)) {
-                const auto matchStart = currTreeStr.find(matchStr);
-                const auto matchEnd = matchStart + matchStr.length();
+        std::size_t matchStart = 0, matchLength = 0;
+        for(const auto &[pattern, tokenType] : compoundPatterns) {
+            while(searchPattern(pattern, currTreeStr, matchStart, matchLength)) {
+                const auto matchEnd = matchStart + matchLength;
                 const auto newTokenPtr = std::make_shared<CompoundToken>(
                     CompoundToken(
                         tokenType,
@@ -104,11 +168,14 @@ const CompoundToken Parser::parseAst(const std::vector<SymbolToken> &tokens) {
                     )
                 );
                 replaceTokens(tokenTree, matchStart, matchEnd, newTokenPtr);
-                currTreeStr = Token::tokenListAsTypeStr(tokenTree);
+                currTreeStr.replace(
+                    matchStart, matchLength, 1, static_cast<char>(tokenType)
+                );
+                changed = true;
             }
         }
         
-        if(currTreeStr == oldStr) {
+        if(!changed) {
             throwUnexpectedTokenException(currTreeStr, tokenTree);
         }
     }
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <string>
+#include <regex>
+#include <random>
+#include <Pattern.hpp>
+
+using namespace kisslang;
+
+/*
+ * Built and run by `make check-patterns`.
+ * Feeds random strings to every lexer and parser table pattern and checks
+ * the compiled program ends its match where std::regex's ECMAScript grammar
+ * does, both anchored (the lexer) and searching (the parser)
+ */
+struct PatternCase {
+    Pattern pattern;
+    const char *source;
+    const char *alphabet;
+};
+
+#define PATTERN_CASE(source, alphabet) { compilePattern(source), source, alphabet }
+
+// Same sources as the tables in Parser.cpp
+static const PatternCase cases[] = {
+    PATTERN_CASE("loop|func|struct", "loopfuncstrx"),
+    PATTERN_CASE("true|false", "truefalsx"),
+    PATTERN_CASE("([0-9]+|0x[0-9A-Za-z]+|0b[01]+):[1248]", "0129xbFg:48"),
+    PATTERN_CASE("([0-9]+\\.[0-9]*|\\.[0-9]+):[48]", "019.:48"),
+    PATTERN_CASE("0c(\\\\.|[^\\\\])", "0c\\'a"),
+    PATTERN_CASE("'(\\\\.|[^\\\\'])*'", "'\\a "),
+    PATTERN_CASE("#:[1248]|\\.:[48]|@|\\?", "#.:148@?"),
+    PATTERN_CASE("[A-Za-z_][A-Za-z_0-9]*", "aZ_09.-"),
+    PATTERN_CASE("\\(|\\)", "()x"),
+    PATTERN_CASE("\\[|\\]", "[]x"),
+    PATTERN_CASE("\\{|\\}", "{}x"),
+    PATTERN_CASE("->", "->x"),
+    PATTERN_CASE("<<|>>", "<>x"),
+    PATTERN_CASE(
+        "\\+\\+|--|==|!=|>=|<=|&&|\\|\\||\\+|-|\\*|\\/|%|>|<|!|&|\\^|~|=",
+        "+-=!<>&|*/%^~x"
+    ),
+    PATTERN_CASE("\\$", "$x"),
+    PATTERN_CASE("::", ":x"),
+    PATTERN_CASE("\\.", ".x"),
+    PATTERN_CASE("[bic'f]", "bic'fx"),
+    PATTERN_CASE("\\(tt\\(", "(tx"),
+    PATTERN_CASE("\\[t+\\[", "[tx"),
+    PATTERN_CASE("\\(n\\(\\{t*\\{", "(n{tx"),
+    PATTERN_CASE("n(\\.n)+", "n.x"),
+    PATTERN_CASE("@|\\$n|(\\(NN\\()|(\\[N\\[)", "@$n(N[x"),
+    PATTERN_CASE("kn:N>N\\}", "kn:N>}x"),
+    PATTERN_CASE("[r,lsS]", "r,lsSx"),
+    PATTERN_CASE("\\{[tFLa=nd]*\\{", "{tFLa=ndx"),
+    PATTERN_CASE("k\\}", "k}x"),
+    PATTERN_CASE("<N<", "<Nx"),
+    PATTERN_CASE("k\\{(n:N)*\\{", "k{n:Nx")
+};
+
+static int failures = 0;
+
+static void expect(
+        const bool condition, const PatternCase &test, const std::string &str,
+        const char *what) {
+    if(!condition) {
+        std::cerr
+            << "FAILED: " << test.source << " " << what
+            << " on \"" << str << "\"" << std::endl;
+        failures++;
+    }
+}
+
+int main() {
+    std::mt19937 random(1);
+    for(const auto &test : cases) {
+        const std::regex regex(test.source, std::regex::ECMAScript);
+        const std::string alphabet(test.alphabet);
+        std::uniform_int_distribution<std::size_t> pick(0, alphabet.length() - 1);
+        std::uniform_int_distribution<std::size_t> length(0, 10);
+        for(int i = 0; i < 20000; i++) {
+            std::string str(length(random), ' ');
+            for(auto &chr : str) {
+                chr = alphabet[pick(random)];
+            }
+
+            std::smatch expected;
+            const bool expectedAnchored = std::regex_search(
+                str, expected, regex, std::regex_constants::match_continuous
+            );
+            const auto found = matchPattern(
+                test.pattern, str.data(), str.data() + str.length()
+            );
+            expect(
+                expectedAnchored == (found != nullptr)
+                    && (!expectedAnchored
+                        || found - str.data() == expected.length(0)),
+                test, str, "anchored match"
+            );
+
+            std::size_t start = 0, matchLength = 0;
+            const bool expectedSearch = std::regex_search(str, expected, regex);
+            const bool searched = searchPattern(
+                test.pattern, str, start, matchLength
+            );
+            expect(
+                expectedSearch == searched
+                    && (!expectedSearch
+                        || (start == static_cast<std::size_t>(
+                                expected.position(0)
+                            )
+                            && matchLength == static_cast<std::size_t>(
+                                expected.length(0)
+                            ))),
+                test, str, "search"
+            );
+        }
+    }
+
+    if(failures != 0) {
+        return 1;
+    }
+    std::cout << "Pattern checks passed" << std::endl;
+    return 0;
+}
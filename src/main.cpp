@@ -1,39 +1,78 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
 #include <Io.hpp>
 #include <Error.hpp>
 #include <Parser.hpp>
 #include <Compiler.hpp>
+#include <Native.hpp>
+#include <Modules.hpp>
+#include <Optimizer.hpp>
 
 using namespace kisslang;
 
-inline void compileSourceCode(
-        const std::string &source, const std::string &moduleName) {
+inline const int compileSourceCode(
+        const std::string &source, const std::string &moduleName,
+        const Io::Options &options) {
     const auto tokens = Parser::lexTokens(source);
-    const auto ast = Parser::parseAst(tokens);    
-    const auto cppCode = Compiler::generateCode(ast);
-    Compiler::compile(moduleName, cppCode);
+    Modules::SourceMap sources;
+    const auto linkedAst = Modules::link(
+        Parser::parseAst(tokens), Io::moduleFileName(moduleName), sources
+    );
+    
+    std::map<std::pair<std::string, std::string>, long long> callCounts;
+    if(options.profileFileName != ""
+            && Io::readProfile(options.profileFileName, callCounts) != 0) {
+        std::cout
+            << "Could not read profile " << options.profileFileName << "."
+            << std::endl;
+        return -1;
+    }
+    
+    std::vector<std::string> report;
+    const auto inlinedAst = Optimizer::inlineCalls(
+        linkedAst, options.inlineThreshold, callCounts, sources, report
+    );
+    const auto ast = Optimizer::eliminateDeadCode(inlinedAst, sources, report);
+    for(const auto &line : report) {
+        std::cout << line << std::endl;
+    }
+    
+    int result = 0;
+    if(options.native) {
+        const auto outputFileName = Io::outputFileName(moduleName);
+        const auto profileFileName = options.instrument ?
+            std::filesystem::absolute(outputFileName + ".kissprof").string()
+            : "";
+        const auto asmCode = Native::generateAssembly(
+            ast, sources, profileFileName
+        );
+        result = Native::assemble(outputFileName, asmCode);
+    } else {
+        const auto cppCode = Compiler::generateCode(ast);
+        Compiler::compile(moduleName, cppCode);
+    }
     
     std::cout << ast.str() << std::endl;
+    return result;
 }
 
 int main(int argc, char **args) {
     std::string sourceCode;
     std::string moduleName;
-    if(Io::sourceCodeFromArgs(sourceCode, moduleName, argc, args) != 0) {
+    Io::Options options;
+    if(Io::sourceCodeFromArgs(
+            sourceCode, moduleName, options, argc, args) != 0) {
         return -1;
     }
     
     std::cout << "Compiling module " << moduleName << "." << std::endl;
     try {
-        compileSourceCode(sourceCode, moduleName);
-    } catch(const UnknownTokenException &ute) {
-        std::cout << ute.what() << std::endl;
-        return -1;
-    } catch(const UnexpectedTokenException &ute) {
-        std::cout << ute.what() << std::endl;
+        return compileSourceCode(sourceCode, moduleName, options);
+    } catch(const SmoochException &se) {
+        std::cout << se.what() << std::endl;
         return -1;
     }
-    
-    return 0;
 }